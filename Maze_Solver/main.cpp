@@ -6,10 +6,21 @@
 #else
   #include <sys/ioctl.h>  // For fetching terminal size on Unix
   #include <unistd.h>
+  #include <sys/socket.h> // Query server
+  #include <sys/un.h>
+  #include <sys/wait.h>   // Sharded worker processes
+  #include <sys/file.h>   // Result cache locking
+  #include <poll.h>
+  #include <csignal>
+  #include <cerrno>
 #endif
 
+#include "maze_core.h"
+
 #include <iostream>
+#include <fstream>
 #include <vector>
+#include <array>
 #include <string>
 #include <queue>
 #include <stack>
@@ -20,90 +31,21 @@
 #include <ctime>
 #include <thread>
 #include <chrono>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <cmath>
+#include <cctype>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 using namespace std;
 
-/* ---------- Disjoint Set (Union‐Find) ---------- */
-struct DisjointSet {
-    vector<int> parent, sz;
-    DisjointSet(int n) {
-        parent.resize(n);
-        iota(parent.begin(), parent.end(), 0);
-        sz.assign(n, 1);
-    }
-    int findRoot(int x) {
-        return parent[x] == x ? x : (parent[x] = findRoot(parent[x]));
-    }
-    void unite(int a, int b) {
-        a = findRoot(a);
-        b = findRoot(b);
-        if (a == b) return;
-        if (sz[a] < sz[b]) swap(a, b);
-        parent[b] = a;
-        sz[a] += sz[b];
-    }
-};
-
-/* ---------- Maze Structure & Random Generation ---------- */
-struct Maze {
-    int mazeW, mazeH;
-    vector<vector<bool>> hasRightWall, hasDownWall;
-
-    Maze(int w, int h): mazeW(w), mazeH(h) {
-        hasRightWall.assign(mazeW, vector<bool>(mazeH, true));
-        hasDownWall.assign(mazeW, vector<bool>(mazeH, true));
-    }
-
-    void generateRandom() {
-        struct Edge { int x, y, dir; };
-        vector<Edge> edges;
-        for (int y = 0; y < mazeH; y++) {
-            for (int x = 0; x < mazeW; x++) {
-                if (x + 1 < mazeW) edges.push_back({x, y, 1});
-                if (y + 1 < mazeH) edges.push_back({x, y, 2});
-            }
-        }
-        mt19937 rng((unsigned)time(NULL));
-        shuffle(edges.begin(), edges.end(), rng);
-
-        DisjointSet ds(mazeW * mazeH);
-        for (auto &e : edges) {
-            int a = e.y * mazeW + e.x;
-            int b = (e.dir == 1) ? (a + 1) : (a + mazeW);
-            if (ds.findRoot(a) != ds.findRoot(b)) {
-                if (e.dir == 1)      hasRightWall[e.x][e.y] = false;
-                else                 hasDownWall[e.x][e.y]  = false;
-                ds.unite(a, b);
-            }
-        }
-    }
-
-    bool canMove(int x, int y, int dir) const {
-        if (dir == 0) {
-            if (y == 0) return false;
-            return !hasDownWall[x][y - 1];
-        }
-        if (dir == 1) {
-            if (x + 1 >= mazeW) return false;
-            return !hasRightWall[x][y];
-        }
-        if (dir == 2) {
-            if (y + 1 >= mazeH) return false;
-            return !hasDownWall[x][y];
-        }
-        if (dir == 3) {
-            if (x == 0) return false;
-            return !hasRightWall[x - 1][y];
-        }
-        return false;
-    }
-};
-
-/* ---------- Helper: cellId ↔ (x,y) ---------- */
-struct Point { int x, y; };
-int cellId(int x, int y, int W) { return y * W + x; }
-Point cellPt(int idx, int W) { return { idx % W, idx / W }; }
-
 /* ---------- ANSI Color Codes ---------- */
 static const string COLOR_CORNER = "\x1b[95m";
 static const string COLOR_HORIZ  = "\x1b[94m";
@@ -125,6 +67,32 @@ inline void ansiHome() {
 /* ---------- Global: animation delay (milliseconds) ---------- */
 int g_delayMs = 150;
 
+/* ---------- Braided mazes (MAZE_BRAID) ---------- */
+// MAZE_BRAID=F (0..1) braids every maze generated from a seed (see
+// Maze::braid), so the solvers face loops and alternative routes, as on
+// real workloads. Unset or 0 keeps mazes perfect. F is kept in parts per
+// million, so spellings that round alike build (and cache as) one maze.
+uint32_t braidPpm() {
+    static const uint32_t ppm = [] {
+        const char *env = getenv("MAZE_BRAID");
+        return env ? (uint32_t)llround(min(max(atof(env), 0.0), 1.0) * 1e6) : 0u;
+    }();
+    return ppm;
+}
+
+double braidFraction() {
+    return braidPpm() / 1e6;
+}
+
+void braidIfAsked(Maze &mz, unsigned seed) {
+    if (braidFraction() > 0) mz.braid(seed, braidFraction());
+}
+
+void generateMaze(Maze &mz, unsigned seed) {
+    mz.generateRandom(seed);
+    braidIfAsked(mz, seed);
+}
+
 /* ---------- ASCII Canvas ---------- */
 struct AsciiCanvas {
     int mazeW, mazeH, rows, cols;
@@ -235,14 +203,14 @@ void drawFrame(
     this_thread::sleep_for(chrono::milliseconds(g_delayMs));
 }
 
-/* ---------- Draw final path in green (“*”) ---------- */
-void drawFinalPath(
+/* ---------- Draw a set of cells in green (“*”) ---------- */
+void drawFinalCells(
     AsciiCanvas &canvas,
-    const vector<int> &parentOf,
-    int endCell
+    const vector<int> &pathCells,
+    const string &statusLine
 ) {
     canvas.resetGrid();
-    for (int v = endCell; v != -1; v = parentOf[v]) {
+    for (int v : pathCells) {
         Point p = cellPt(v, canvas.mazeW);
         canvas.drawGrid[2*p.y + 1][2*p.x + 1] = '*';
     }
@@ -258,7 +226,7 @@ void drawFinalPath(
     }
 
     ansiHome();
-    cout << "\x1b[2K" << "FINAL (exit found) - displaying path\n";
+    cout << "\x1b[2K" << statusLine << "\n";
     for (int r = 0; r < canvas.rows; r++) {
         for (int c = 0; c < canvas.cols; c++) {
             char ch = canvas.drawGrid[r][c];
@@ -276,45 +244,98 @@ void drawFinalPath(
     this_thread::sleep_for(chrono::seconds(2));
 }
 
+/* ---------- Draw final path in green (“*”) ---------- */
+template<typename Parents>
+vector<int> pathCellsFrom(const Parents &parentOf, int endCell) {
+    vector<int> pathCells;
+    for (int v = endCell; v != -1; v = parentOf[v]) pathCells.push_back(v);
+    return pathCells;
+}
+
+template<typename Parents>
+void drawFinalPath(
+    AsciiCanvas &canvas,
+    const Parents &parentOf,
+    int endCell,
+    const string &statusLine = "FINAL (exit found) - displaying path"
+) {
+    drawFinalCells(canvas, pathCellsFrom(parentOf, endCell), statusLine);
+}
+
+/* ---------- Outcome of a run with animation skipped ---------- */
+// Everything a skipped run shows: the highlighted cells and the status
+// line. The skipX solvers below compute it without touching the terminal,
+// so they can also run ahead on a worker thread (see Speculative runs).
+// cells runs goal to start and is empty when the goal is unreachable.
+struct SolveOutcome {
+    vector<int> cells;
+    string status;
+};
+
+// Optional hooks on skipDFS/skipBFS/skipPQ, for race mode and --solve:
+// onDiscover(v) when a cell enters the frontier, onExpand(u) the first
+// time a cell is expanded, so counts compare across solvers.
+struct NoObserver { void operator()(int) const {} };
+
+void showOutcome(const Maze &mz, const SolveOutcome &out) {
+    AsciiCanvas canvas(mz);
+    drawFinalCells(canvas, out.cells, out.status);
+}
+
 /* ---------- DFS (supports skipping animation) ---------- */
-void runDFS(const Maze &mz, bool skipAnimation) {
-    int W = mz.mazeW, H = mz.mazeH, N = W * H;
+// A cell is expanded once, when it is pushed; backtracking onto it again
+// only looks for its next unvisited neighbour.
+template<typename OnDiscover = NoObserver, typename OnExpand = NoObserver>
+SolveOutcome skipDFS(const Maze &mz, OnDiscover onDiscover = {}, OnExpand onExpand = {}) {
+    int W = mz.mazeW, H = mz.mazeH, N = W * H, goal = cellId(W-1, H-1, W);
     vector<int> parentOf(N, -1);
-    unordered_set<int> visitedSet;
+    vector<char> seen(N, 0);
     vector<int> stk;
 
-    if (skipAnimation) {
-        stk.push_back(0);
-        visitedSet.insert(0);
-        while (!stk.empty()) {
-            int u = stk.back();
-            Point pu = cellPt(u, W);
-            if (u == cellId(W-1, H-1, W)) break;
+    stk.push_back(0);
+    seen[0] = 1;
+    onDiscover(0);
+    onExpand(0);
+    bool found = false;
+    while (!stk.empty()) {
+        int u = stk.back();
+        Point pu = cellPt(u, W);
+        if (u == goal) { found = true; break; }
 
-            int nextCell = -1;
-            for (int dir = 0; dir < 4; dir++) {
-                int nx = pu.x + (dir==1) - (dir==3);
-                int ny = pu.y + (dir==2) - (dir==0);
-                if (nx<0||nx>=W||ny<0||ny>=H) continue;
-                int vid = cellId(nx, ny, W);
-                if (mz.canMove(pu.x, pu.y, dir) && !visitedSet.count(vid)) {
-                    nextCell = vid;
-                    break;
-                }
-            }
-            if (nextCell != -1) {
-                parentOf[nextCell] = u;
-                stk.push_back(nextCell);
-                visitedSet.insert(nextCell);
-            } else {
-                stk.pop_back();
+        int nextCell = -1;
+        for (int dir = 0; dir < 4; dir++) {
+            int nx = pu.x + (dir==1) - (dir==3);
+            int ny = pu.y + (dir==2) - (dir==0);
+            if (nx<0||nx>=W||ny<0||ny>=H) continue;
+            int vid = cellId(nx, ny, W);
+            if (mz.canMove(pu.x, pu.y, dir) && !seen[vid]) {
+                nextCell = vid;
+                break;
             }
         }
-        AsciiCanvas canvas(mz);
-        drawFinalPath(canvas, parentOf, cellId(W-1, H-1, W));
+        if (nextCell != -1) {
+            parentOf[nextCell] = u;
+            stk.push_back(nextCell);
+            seen[nextCell] = 1;
+            onDiscover(nextCell);
+            onExpand(nextCell);
+        } else {
+            stk.pop_back();
+        }
+    }
+    return { found ? pathCellsFrom(parentOf, goal) : vector<int>(), "FINAL (exit found) - displaying path" };
+}
+
+void runDFS(const Maze &mz, bool skipAnimation) {
+    if (skipAnimation) {
+        showOutcome(mz, skipDFS(mz));
         return;
     }
 
+    int W = mz.mazeW, H = mz.mazeH, N = W * H;
+    vector<int> parentOf(N, -1);
+    unordered_set<int> visitedSet;
+    vector<int> stk;
     AsciiCanvas canvas(mz);
     stk.push_back(0);
     visitedSet.insert(0);
@@ -369,36 +390,48 @@ void runDFS(const Maze &mz, bool skipAnimation) {
 }
 
 /* ---------- BFS (supports skipping animation) ---------- */
-void runBFS(const Maze &mz, bool skipAnimation) {
-    int W = mz.mazeW, H = mz.mazeH, N = W * H;
+template<typename OnDiscover = NoObserver, typename OnExpand = NoObserver>
+SolveOutcome skipBFS(const Maze &mz, OnDiscover onDiscover = {}, OnExpand onExpand = {}) {
+    int W = mz.mazeW, H = mz.mazeH, N = W * H, goal = cellId(W-1, H-1, W);
     vector<int> parentOf(N, -1);
-    unordered_set<int> visitedSet;
+    vector<char> seen(N, 0);
     queue<int> que;
 
-    if (skipAnimation) {
-        que.push(0);
-        visitedSet.insert(0);
-        while (!que.empty()) {
-            int u = que.front(); que.pop();
-            if (u == cellId(W-1, H-1, W)) break;
-            Point pu = cellPt(u, W);
-            for (int dir = 0; dir < 4; dir++) {
-                int nx = pu.x + (dir==1) - (dir==3);
-                int ny = pu.y + (dir==2) - (dir==0);
-                if (nx<0||nx>=W||ny<0||ny>=H) continue;
-                int vid = cellId(nx, ny, W);
-                if (mz.canMove(pu.x, pu.y, dir) && !visitedSet.count(vid)) {
-                    visitedSet.insert(vid);
-                    parentOf[vid] = u;
-                    que.push(vid);
-                }
+    que.push(0);
+    seen[0] = 1;
+    onDiscover(0);
+    bool found = false;
+    while (!que.empty()) {
+        int u = que.front(); que.pop();
+        onExpand(u);
+        if (u == goal) { found = true; break; }
+        Point pu = cellPt(u, W);
+        for (int dir = 0; dir < 4; dir++) {
+            int nx = pu.x + (dir==1) - (dir==3);
+            int ny = pu.y + (dir==2) - (dir==0);
+            if (nx<0||nx>=W||ny<0||ny>=H) continue;
+            int vid = cellId(nx, ny, W);
+            if (mz.canMove(pu.x, pu.y, dir) && !seen[vid]) {
+                seen[vid] = 1;
+                parentOf[vid] = u;
+                onDiscover(vid);
+                que.push(vid);
             }
         }
-        AsciiCanvas canvas(mz);
-        drawFinalPath(canvas, parentOf, cellId(W-1, H-1, W));
+    }
+    return { found ? pathCellsFrom(parentOf, goal) : vector<int>(), "FINAL (exit found) - displaying path" };
+}
+
+void runBFS(const Maze &mz, bool skipAnimation) {
+    if (skipAnimation) {
+        showOutcome(mz, skipBFS(mz));
         return;
     }
 
+    int W = mz.mazeW, H = mz.mazeH, N = W * H;
+    vector<int> parentOf(N, -1);
+    unordered_set<int> visitedSet;
+    queue<int> que;
     AsciiCanvas canvas(mz);
     que.push(0);
     visitedSet.insert(0);
@@ -440,44 +473,67 @@ void runBFS(const Maze &mz, bool skipAnimation) {
 }
 
 /* ---------- Dijkstra / A* (supports skipping animation) ---------- */
-template<typename Heuristic>
-void runPQ(const Maze &mz, Heuristic h, const string &algoName, bool skipAnimation) {
-    int W = mz.mazeW, H = mz.mazeH, N = W * H;
-    vector<int> dist(N, INT_MAX), parentOf(N, -1);
-    unordered_set<int> visitedSet;
+// Stale heap entries (a cell already expanded) are dropped, so each cell
+// is expanded and counted once.
+template<typename Heuristic, typename OnDiscover = NoObserver, typename OnExpand = NoObserver>
+SolveOutcome skipPQ(const Maze &mz, Heuristic h, const string &algoName,
+                    OnDiscover onDiscover = {}, OnExpand onExpand = {}) {
+    int W = mz.mazeW, H = mz.mazeH, N = W * H, goal = cellId(W-1, H-1, W);
+    // Paged so a short search on a huge maze costs what it touches, not O(N).
+    PagedArray<int> dist(N, INT_MAX), parentOf(N, -1);
+    PagedArray<uint8_t> closed(N, 0);
+    long long expanded = 0;
     using P = pair<int,int>;
-    priority_queue<P, vector<P>, greater<P>> pq;
+    priority_queue<P, vector<P, LargePageAllocator<P>>, greater<P>> pq;
 
     dist[0] = 0;
     pq.push({ h(0), 0 });
-
-    if (skipAnimation) {
-        visitedSet.insert(0);
-        while (!pq.empty()) {
-            int u = pq.top().second; pq.pop();
-            if (u == cellId(W-1, H-1, W)) break;
-            if (!visitedSet.count(u)) visitedSet.insert(u);
-            Point pu = cellPt(u, W);
-            for (int dir = 0; dir < 4; dir++) {
-                int nx = pu.x + (dir==1) - (dir==3);
-                int ny = pu.y + (dir==2) - (dir==0);
-                if (nx<0||nx>=W||ny<0||ny>=H) continue;
-                int vid = cellId(nx, ny, W);
-                if (mz.canMove(pu.x, pu.y, dir)) {
-                    int alt = dist[u] + 1;
-                    if (alt < dist[vid]) {
-                        dist[vid] = alt;
-                        parentOf[vid] = u;
-                        pq.push({ alt + h(vid), vid });
-                    }
+    onDiscover(0);
+    bool found = false;
+    while (!pq.empty()) {
+        int u = pq.top().second; pq.pop();
+        if (closed[u]) continue;
+        closed[u] = 1;
+        expanded++;
+        onExpand(u);
+        if (u == goal) { found = true; break; }
+        Point pu = cellPt(u, W);
+        for (int dir = 0; dir < 4; dir++) {
+            int nx = pu.x + (dir==1) - (dir==3);
+            int ny = pu.y + (dir==2) - (dir==0);
+            if (nx<0||nx>=W||ny<0||ny>=H) continue;
+            int vid = cellId(nx, ny, W);
+            if (mz.canMove(pu.x, pu.y, dir)) {
+                int alt = dist[u] + 1;
+                if (alt < dist[vid]) {
+                    dist[vid] = alt;
+                    parentOf[vid] = u;
+                    onDiscover(vid);
+                    pq.push({ alt + h(vid), vid });
                 }
             }
         }
-        AsciiCanvas canvas(mz);
-        drawFinalPath(canvas, parentOf, cellId(W-1, H-1, W));
+    }
+    return { found ? pathCellsFrom(parentOf, goal) : vector<int>(),
+             "FINAL (exit found) - " + algoName + ": " +
+             to_string(expanded) + " cells expanded" };
+}
+
+template<typename Heuristic>
+void runPQ(const Maze &mz, Heuristic h, const string &algoName, bool skipAnimation) {
+    if (skipAnimation) {
+        showOutcome(mz, skipPQ(mz, h, algoName));
         return;
     }
 
+    int W = mz.mazeW, H = mz.mazeH, N = W * H;
+    PagedArray<int> dist(N, INT_MAX), parentOf(N, -1);
+    unordered_set<int> visitedSet;
+    using P = pair<int,int>;
+    priority_queue<P, vector<P, LargePageAllocator<P>>, greater<P>> pq;
+
+    dist[0] = 0;
+    pq.push({ h(0), 0 });
     AsciiCanvas canvas(mz);
     visitedSet.insert(0);
 
@@ -530,136 +586,3765 @@ void runPQ(const Maze &mz, Heuristic h, const string &algoName, bool skipAnimati
         }
     }
 
-    drawFinalPath(canvas, parentOf, cellId(W-1, H-1, W));
+    drawFinalPath(canvas, parentOf, cellId(W-1, H-1, W),
+                  "FINAL (exit found) - " + algoName + ": " +
+                  to_string(visitedSet.size()) + " cells expanded");
 }
 
-/* ---------- Print Legend ---------- */
-void printLegend() {
-    ansiClear();
-    cout << "Legend:\n";
-    cout << COLOR_CORNER << "+ " << COLOR_RESET << ": corner of wall\n";
-    cout << COLOR_HORIZ  << "- " << COLOR_RESET << ": horizontal wall\n";
-    cout << COLOR_VERT   << "| " << COLOR_RESET << ": vertical wall\n";
-    cout << COLOR_VISIT  << ". " << COLOR_RESET << ": visited cell (white)\n";
-    cout << COLOR_FRONT  << "o " << COLOR_RESET << ": frontier (yellow)\n";
-    cout << COLOR_CUR    << "@ " << COLOR_RESET << ": current cell (red)\n";
-    cout << COLOR_PATH   << "* " << COLOR_RESET << ": final path (green)\n";
-    cout << "\nPress Enter to continue...\n";
-    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-}
+/* ---------- Low-memory solvers: result of a walk ---------- */
+// pathLen is the length of the route the solver reports (in moves);
+// steps counts every move it made, backtracking included.
+struct WalkStats {
+    bool reached;
+    long long pathLen, steps;
+};
 
-/* ---------- Prompt for speed (faster top speed) ---------- */
-void promptSpeed() {
-    int s;
-    while (true) {
-        ansiClear();
-        cout << "Choose speed (1=slow ... 10=fast): ";
-        if (!(cin >> s)) {
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            continue;
-        }
-        if (s >= 1 && s <= 10) break;
-    }
-    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+/* ---------- Wall follower (left hand, O(1) extra memory) ---------- */
+// Keeps only position and heading. Start and goal both touch the outer
+// wall, so the left-hand walk always arrives; the step cap only guards
+// against a maze that is not connected. With no memory the walk cannot
+// erase its own detours, so the reported route is the walk itself.
+template<typename OnMove>
+WalkStats followWallLeft(const Maze &mz, OnMove onMove) {
+    int W = mz.mazeW, H = mz.mazeH;
+    long long maxSteps = 4LL * W * H + 4;
+    int x = 0, y = 0, heading = 1;   // enter through the west opening
+    long long steps = 0;
 
-    switch (s) {
-        case 1:  g_delayMs = 500; break;
-        case 2:  g_delayMs = 300; break;
-        case 3:  g_delayMs = 200; break;
-        case 4:  g_delayMs = 100; break;
-        case 5:  g_delayMs = 80;  break;
-        case 6:  g_delayMs = 60;  break;
-        case 7:  g_delayMs = 40;  break;
-        case 8:  g_delayMs = 25;  break;
-        case 9:  g_delayMs = 10;  break;
-        case 10: g_delayMs = 1;   break;  // Top speed → 1 ms delay
-        default: g_delayMs = 150; break;
+    while (!(x == W - 1 && y == H - 1)) {
+        if (steps >= maxSteps) return { false, steps, steps };
+        int dir = -1;
+        for (int turn : { 3, 0, 1, 2 }) {     // left, straight, right, back
+            int d = (heading + turn) % 4;
+            if (mz.canMove(x, y, d)) { dir = d; break; }
+        }
+        if (dir == -1) return { false, steps, steps };   // walled-in 1x1
+        x += (dir==1) - (dir==3);
+        y += (dir==2) - (dir==0);
+        heading = dir;
+        steps++;
+        onMove(cellId(x, y, W));
     }
+    return { true, steps, steps };
 }
 
-/* ---------- Main Program ---------- */
-int main() {
-    // Hide the cursor (ANSI code)
-    cout << "\x1b[?25l";
+/* ---------- Tremaux marks: 2 bits per passage, bit-packed ---------- */
+// Each cell owns its right and down passage, so a cell needs 4 bits and
+// a 64-bit word covers 16 cells (N/2 bytes in total).
+struct TremauxMarks {
+    int mazeW;
+    vector<uint64_t> words;
 
-    int mazeWidth = 30, mazeHeight = 15;
+    TremauxMarks(int w, int h): mazeW(w), words(((size_t)w * h + 15) / 16, 0) {}
 
-    while (true) {
-        // ── Generate a new maze ──
-        Maze mazeObj(mazeWidth, mazeHeight);
-        mazeObj.generateRandom();
+    // Bit offset of the passage leaving (x,y) in direction dir.
+    size_t slot(int x, int y, int dir) const {
+        if (dir == 0) { y -= 1; dir = 2; }
+        if (dir == 3) { x -= 1; dir = 1; }
+        size_t cell = (size_t)y * mazeW + x;
+        return cell * 4 + (dir == 2 ? 2 : 0);
+    }
+    int get(int x, int y, int dir) const {
+        size_t s = slot(x, y, dir);
+        return (int)((words[s / 64] >> (s % 64)) & 3);
+    }
+    void bump(int x, int y, int dir) {
+        size_t s = slot(x, y, dir);
+        if (((words[s / 64] >> (s % 64)) & 3) < 3) words[s / 64] += 1ULL << (s % 64);
+    }
+};
 
-        // Show the empty maze immediately after generation
-        {
-            AsciiCanvas canvas(mazeObj);
-            // Ensure terminal is large enough
-            while (true) {
-                auto sz = getTerminalSize();
-                int t_rows = sz.first, t_cols = sz.second;
-                int need_rows = canvas.rows + 1;
-                int need_cols = canvas.cols;
-                if (t_rows >= need_rows && t_cols >= need_cols) break;
-                ansiClear();
-                cout << "Terminal too small. Please resize to at least "
-                     << need_cols << "x" << need_rows << ".\n";
-                this_thread::sleep_for(chrono::milliseconds(200));
-            }
-            // Draw empty maze (no visits, no frontier, no current)
-            ansiClear();
-            // Status line for empty maze
-            cout << "EMPTY MAZE - use terminal commands to continue\n";
-            for (int r = 0; r < canvas.rows; r++) {
-                for (int c = 0; c < canvas.cols; c++) {
-                    char ch = canvas.baseGrid[r][c];
-                    switch (ch) {
-                        case '+': cout << COLOR_CORNER << ch << COLOR_RESET; break;
-                        case '-': cout << COLOR_HORIZ  << ch << COLOR_RESET; break;
-                        case '|': cout << COLOR_VERT   << ch << COLOR_RESET; break;
-                        default:  cout << ch;
-                    }
-                }
-                cout << "\n";
-            }
-            cout << "\nPress Enter to continue...\n";
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+/* ---------- Tremaux walk ---------- */
+// Classic rules: mark a passage each time it is walked; on reaching an
+// already-marked cell through a fresh passage, turn back; otherwise take
+// an unmarked passage, else one marked once, never one marked twice.
+template<typename OnMove>
+WalkStats tremauxWalk(const Maze &mz, TremauxMarks &marks, OnMove onMove) {
+    int W = mz.mazeW, H = mz.mazeH;
+    int x = 0, y = 0, came = -1;
+    long long steps = 0;
+
+    while (!(x == W - 1 && y == H - 1)) {
+        int back = (came == -1) ? -1 : (came + 2) % 4;
+        bool seenBefore = false;
+        for (int d = 0; d < 4; d++) {
+            if (d != back && mz.canMove(x, y, d) && marks.get(x, y, d) > 0)
+                seenBefore = true;
         }
 
-        // Loop: allow running different algorithms on the same maze
-        while (true) {
-            ansiClear();
-            cout << "Maze " << mazeWidth << "x" << mazeHeight << " generated\n"
-                 << "1) DFS   2) BFS   3) Dijkstra   4) A*\n"
-                 << "q) Quit\n> ";
-            char choice;
-            cin >> choice;
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            if (choice == 'q' || choice == 'Q') {
-                // Show cursor again before exiting
-                cout << "\x1b[?25h";
-                return 0;
+        int dir = -1;
+        if (back != -1 && seenBefore && marks.get(x, y, back) == 1) {
+            dir = back;
+        } else {
+            int best = 2;
+            for (int d = 0; d < 4; d++) {
+                if (d == back || !mz.canMove(x, y, d)) continue;
+                int m = marks.get(x, y, d);
+                if (m < best) { best = m; dir = d; }
             }
+            if (dir == -1 && back != -1 && marks.get(x, y, back) < 2) dir = back;
+        }
+        if (dir == -1) return { false, 0, steps };
 
-            // Print legend
+        marks.bump(x, y, dir);
+        x += (dir==1) - (dir==3);
+        y += (dir==2) - (dir==0);
+        came = dir;
+        steps++;
+        onMove(cellId(x, y, W));
+    }
+    return { true, 0, steps };
+}
+
+// Passages marked exactly once form the route from the start to the goal.
+template<typename OnCell>
+long long tremauxPath(const Maze &mz, const TremauxMarks &marks, OnCell onCell) {
+    int W = mz.mazeW, H = mz.mazeH;
+    int x = 0, y = 0, came = -1;
+    long long len = 0;
+    onCell(0);
+    while (!(x == W - 1 && y == H - 1)) {
+        int dir = -1;
+        for (int d = 0; d < 4; d++) {
+            if (came != -1 && d == (came + 2) % 4) continue;
+            if (mz.canMove(x, y, d) && marks.get(x, y, d) == 1) { dir = d; break; }
+        }
+        if (dir == -1) return -1;
+        x += (dir==1) - (dir==3);
+        y += (dir==2) - (dir==0);
+        came = dir;
+        len++;
+        onCell(cellId(x, y, W));
+    }
+    return len;
+}
+
+/* ---------- Wall follower / Tremaux (supports skipping animation) ---------- */
+// The display keeps only the last TRAIL cells walked, so showing a walk
+// stays O(1) like the walkers themselves rather than O(steps).
+struct WalkTrail {
+    static const size_t TRAIL = 256;
+    deque<int> cells;
+    void push(int v) {
+        cells.push_back(v);
+        if (cells.size() > TRAIL) cells.pop_front();
+    }
+};
+
+// Tremaux shows its route, read back from the marks it already keeps; the
+// wall follower, which has nothing to read back, shows its last steps.
+template<typename OnMove>
+SolveOutcome walkLowMemory(const Maze &mz, bool useTremaux, OnMove onMove) {
+    int W = mz.mazeW, H = mz.mazeH;
+    string algoName = useTremaux ? "Tremaux" : "Wall follower";
+    WalkStats st;
+    vector<int> pathCells;
+    string shown;
+    if (useTremaux) {
+        TremauxMarks marks(W, H);
+        st = tremauxWalk(mz, marks, onMove);
+        if (st.reached)
+            st.pathLen = tremauxPath(mz, marks, [&](int v){ pathCells.push_back(v); });
+    } else {
+        WalkTrail trail;
+        trail.push(0);
+        st = followWallLeft(mz, [&](int v){ onMove(v); trail.push(v); });
+        pathCells.assign(trail.cells.begin(), trail.cells.end());
+        if (st.steps + 1 > (long long)WalkTrail::TRAIL)
+            shown = ", last " + to_string(WalkTrail::TRAIL) + " cells shown";
+    }
+
+    string status = st.reached
+        ? "FINAL (exit found) - " + algoName + ": path " + to_string(st.pathLen) +
+          " moves, " + to_string(st.steps) + " steps taken" + shown
+        : "FINAL - " + algoName + ": exit not reached after " +
+          to_string(st.steps) + " steps" + shown;
+    return { move(pathCells), status };
+}
+
+SolveOutcome skipLowMemory(const Maze &mz, bool useTremaux) {
+    return walkLowMemory(mz, useTremaux, [](int){});
+}
+
+void runLowMemory(const Maze &mz, bool useTremaux, bool skipAnimation) {
+    if (skipAnimation) {
+        showOutcome(mz, skipLowMemory(mz, useTremaux));
+        return;
+    }
+
+    int W = mz.mazeW;
+    string algoName = useTremaux ? "Tremaux" : "Wall follower";
+    AsciiCanvas canvas(mz);
+    WalkTrail trail;                 // display only; the solvers never read it
+
+    ansiClear();
+    cout << "Please resize terminal to fit entire maze, then press Enter...\n";
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    ansiClear();
+    trail.push(0);
+    drawFrame(canvas, {}, { 0 }, 0, algoName + " - starting " + algoName);
+
+    SolveOutcome out = walkLowMemory(mz, useTremaux, [&](int v) {
+        trail.push(v);
+        Point p = cellPt(v, W);
+        drawFrame(canvas, {}, unordered_set<int>(trail.cells.begin(), trail.cells.end()), v,
+                  algoName + " - step to (" + to_string(p.x) + "," + to_string(p.y) + ")");
+    });
+    drawFinalCells(canvas, out.cells, out.status);
+}
+
+/* ---------- Lowest set bit of a wall bitmap word ---------- */
+inline int lowestBit(uint64_t b) {
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanForward64(&i, b);
+    return (int)i;
+#else
+    return __builtin_ctzll(b);
+#endif
+}
+
+/* ---------- Word-parallel ops for the bitboard kernels ---------- */
+// The row kernels are written once against these ops; each flavour moves
+// `lanes` 64-bit words (64 cells each) per instruction. The kernels are
+// force-inlined into per-ISA entry points (see Runtime SIMD dispatch), so
+// the same source compiles to scalar, SSE, AVX2 or AVX-512 code.
+#if defined(__GNUC__)
+  #define MAZE_INLINE __attribute__((always_inline)) inline
+#else
+  #define MAZE_INLINE inline
+#endif
+
+struct ScalarWords {
+    using Vec = uint64_t;
+    static const int lanes = 1;
+    static MAZE_INLINE Vec load(const uint64_t *p)      { return *p; }
+    static MAZE_INLINE void store(uint64_t *p, Vec v)   { *p = v; }
+    static MAZE_INLINE Vec zero()                       { return 0; }
+    static MAZE_INLINE Vec vand(Vec a, Vec b)           { return a & b; }
+    static MAZE_INLINE Vec vor(Vec a, Vec b)            { return a | b; }
+    static MAZE_INLINE Vec andNot(Vec a, Vec b)         { return ~a & b; }
+    template<int n> static MAZE_INLINE Vec shl(Vec a)   { return a << n; }
+    template<int n> static MAZE_INLINE Vec shr(Vec a)   { return a >> n; }
+    static MAZE_INLINE uint64_t orAll(Vec a)            { return a; }
+};
+
+#if defined(__GNUC__)
+// GCC/Clang vector extensions: the instruction set is whatever the
+// enclosing function is compiled for, so no intrinsics are needed. Vec
+// wraps the vector in a struct so none is ever a bare return type, which
+// GCC would flag (-Wpsabi) for AVX widths in code built without AVX;
+// everything is force-inlined, so the wrapper costs nothing.
+typedef uint64_t U64x2 __attribute__((vector_size(16)));
+typedef uint64_t U64x4 __attribute__((vector_size(32)));
+typedef uint64_t U64x8 __attribute__((vector_size(64)));
+template<int L> struct U64xN;
+template<> struct U64xN<2> { typedef U64x2 type; };
+template<> struct U64xN<4> { typedef U64x4 type; };
+template<> struct U64xN<8> { typedef U64x8 type; };
+
+template<int L>
+struct VecWords {
+    struct Vec { typename U64xN<L>::type v; };
+    static const int lanes = L;
+    static MAZE_INLINE Vec load(const uint64_t *p)                  { Vec r; memcpy(&r.v, p, sizeof r.v); return r; }
+    static MAZE_INLINE void store(uint64_t *p, const Vec &a)        { memcpy(p, &a.v, sizeof a.v); }
+    static MAZE_INLINE Vec zero()                                   { return Vec{}; }
+    static MAZE_INLINE Vec vand(const Vec &a, const Vec &b)         { return { a.v & b.v }; }
+    static MAZE_INLINE Vec vor(const Vec &a, const Vec &b)          { return { a.v | b.v }; }
+    static MAZE_INLINE Vec andNot(const Vec &a, const Vec &b)       { return { ~a.v & b.v }; }
+    template<int n> static MAZE_INLINE Vec shl(const Vec &a)        { return { a.v << n }; }
+    template<int n> static MAZE_INLINE Vec shr(const Vec &a)        { return { a.v >> n }; }
+    static MAZE_INLINE uint64_t orAll(const Vec &a) {
+        uint64_t r = 0;
+        for (int i = 0; i < L; i++) r |= a.v[i];
+        return r;
+    }
+};
+#endif
+
+/* ---------- Kernel table (filled in by Runtime SIMD dispatch) ---------- */
+struct SmallMaze;
+struct SimdKernels {
+    const char *name;
+    uint64_t (*wavefrontRow)(const uint64_t *f, const uint64_t *R, const uint64_t *D,
+                             const uint64_t *V, uint64_t *out, int words, int stride);
+    uint64_t (*deadEndRow)(uint64_t *A, const uint64_t *Au, const uint64_t *Ad,
+                           const uint64_t *R, const uint64_t *D, const uint64_t *keep,
+                           int words, int stride);
+    void (*solveLanes)(const SmallMaze *mazes, int count, int *lengths);
+    int batchLanes;
+};
+const SimdKernels &simdKernels();
+
+/* ---------- Bit-parallel BFS: one wavefront row step ---------- */
+// out = cells of row y reachable in one move from the frontier, minus the
+// visited ones. f points at row y of the frontier; rows y-1 and y+1 are
+// one stride away. Returns the OR of all output words.
+template<typename O>
+MAZE_INLINE uint64_t wavefrontRowWith(
+    const uint64_t *f, const uint64_t *R, const uint64_t *D, const uint64_t *V,
+    uint64_t *out, int words, int stride
+) {
+    const uint64_t *fu = f - stride, *fd = f + stride, *Du = D - stride;
+    typename O::Vec acc = O::zero();
+    int i = 0;
+    for (; i + O::lanes <= words; i += O::lanes) {
+        auto fc = O::load(f + i), rc = O::load(R + i);
+        auto right = O::vor(O::template shl<1>(O::vand(fc, rc)),
+                            O::template shr<63>(O::vand(O::load(f + i - 1), O::load(R + i - 1))));
+        auto left  = O::vand(O::vor(O::template shr<1>(fc),
+                                    O::template shl<63>(O::load(f + i + 1))), rc);
+        auto vert  = O::vor(O::vand(O::load(fu + i), O::load(Du + i)),
+                            O::vand(O::load(fd + i), O::load(D + i)));
+        auto o = O::andNot(O::load(V + i), O::vor(O::vor(right, left), vert));
+        O::store(out + i, o);
+        acc = O::vor(acc, o);
+    }
+    uint64_t any = O::orAll(acc);
+    if constexpr (O::lanes > 1)
+        if (i < words) any |= wavefrontRowWith<ScalarWords>(f + i, R + i, D + i, V + i,
+                                                             out + i, words - i, stride);
+    return any;
+}
+
+/* ---------- Bit-parallel BFS: distance layers ---------- */
+// Advances the whole wavefront a layer at a time, 64 cells per word. Only
+// rows next to a non-empty frontier row are touched, and within a row only
+// the words next to the frontier's word range. Fills dist with the BFS
+// distance of every cell from source (-1 if unreachable) and stops after
+// the layer that reaches stopCell, if given (-1 for the whole maze).
+// onLayer(d) runs once layer d is in dist.
+template<typename OnLayer>
+void bitBfsDistances(const MazeBits &mb, int source, int stopCell,
+                     CellVector &dist, OnLayer onLayer) {
+    int W = mb.mazeW, H = mb.mazeH, words = mb.words, stride = mb.stride;
+    auto wavefrontRow = simdKernels().wavefrontRow;
+    dist.assign((size_t)W * H, -1);
+    WordVector front(mb.openRight.size(), 0), next(front.size(), 0), seen(front.size(), 0);
+    vector<int> rowStamp(H, -1), activeRows, nextRows;
+    // Word range [lo, hi] holding the frontier of each row (empty: lo > hi).
+    vector<int> frontLo(H, words), frontHi(H, -1), nextLo(H, words), nextHi(H, -1);
+
+    Point ps = cellPt(source, W);
+    mb.rowOf(front, ps.y)[ps.x / 64] |= 1ULL << (ps.x % 64);
+    mb.rowOf(seen, ps.y)[ps.x / 64]  |= 1ULL << (ps.x % 64);
+    frontLo[ps.y] = frontHi[ps.y] = ps.x / 64;
+    dist[source] = 0;
+    activeRows.push_back(ps.y);
+    onLayer(0);
+
+    for (int layer = 1; !activeRows.empty() && (stopCell < 0 || dist[stopCell] < 0); layer++) {
+        nextRows.clear();
+        for (int a : activeRows) {
+            for (int y = max(a - 1, 0); y <= min(a + 1, H - 1); y++) {
+                if (rowStamp[y] == layer) continue;
+                rowStamp[y] = layer;
+                int lo = words, hi = -1;
+                for (int yy = max(y - 1, 0); yy <= min(y + 1, H - 1); yy++) {
+                    lo = min(lo, frontLo[yy]);
+                    hi = max(hi, frontHi[yy]);
+                }
+                lo = max(lo - 1, 0);
+                hi = min(hi + 1, words - 1);
+
+                size_t off = mb.rowOffset(y) + lo;
+                uint64_t *out = next.data() + off;
+                if (!wavefrontRow(front.data() + off, mb.openRight.data() + off,
+                                  mb.openDown.data() + off, seen.data() + off,
+                                  out, hi - lo + 1, stride)) continue;
+                nextRows.push_back(y);
+                uint64_t *vis = seen.data() + off;
+                for (int i = 0; i <= hi - lo; i++) {
+                    if (!out[i]) continue;
+                    vis[i] |= out[i];
+                    nextLo[y] = min(nextLo[y], lo + i);
+                    nextHi[y] = lo + i;
+                    size_t base = (size_t)y * W + (size_t)(lo + i) * 64;
+                    for (uint64_t b = out[i]; b; b &= b - 1)
+                        dist[base + lowestBit(b)] = layer;
+                }
+            }
+        }
+        // Clear the old frontier so its buffer can take the next layer.
+        for (int a : activeRows) {
+            fill(front.begin() + mb.rowOffset(a) + frontLo[a],
+                 front.begin() + mb.rowOffset(a) + frontHi[a] + 1, 0);
+            frontLo[a] = words;
+            frontHi[a] = -1;
+        }
+        swap(front, next);
+        swap(frontLo, nextLo);
+        swap(frontHi, nextHi);
+        swap(activeRows, nextRows);
+        if (!activeRows.empty()) onLayer(layer);
+    }
+}
+
+// Walks downhill from goal; parentOf is filled only along the path.
+vector<int> parentsFromDistances(const Maze &mz, const CellVector &dist, int goal) {
+    int W = mz.mazeW;
+    vector<int> parentOf(dist.size(), -1);
+    if (dist[goal] < 0) return parentOf;
+    for (int v = goal; dist[v] > 0; ) {
+        Point p = cellPt(v, W);
+        for (int dir = 0; dir < 4; dir++) {
+            if (!mz.canMove(p.x, p.y, dir)) continue;
+            int u = cellId(p.x + (dir==1) - (dir==3), p.y + (dir==2) - (dir==0), W);
+            if (dist[u] == dist[v] - 1) { parentOf[v] = u; v = u; break; }
+        }
+    }
+    return parentOf;
+}
+
+/* ---------- Bit-parallel BFS (supports skipping animation) ---------- */
+SolveOutcome skipBitBFS(const Maze &mz) {
+    int W = mz.mazeW, H = mz.mazeH, goal = cellId(W-1, H-1, W);
+    MazeBits mb(mz);
+    CellVector dist;
+    bitBfsDistances(mb, 0, goal, dist, [](int){});
+    return { pathCellsFrom(parentsFromDistances(mz, dist, goal), goal),
+             "FINAL (exit found) - displaying path" };
+}
+
+void runBitBFS(const Maze &mz, bool skipAnimation) {
+    if (skipAnimation) {
+        showOutcome(mz, skipBitBFS(mz));
+        return;
+    }
+
+    int W = mz.mazeW, H = mz.mazeH, goal = cellId(W-1, H-1, W);
+    MazeBits mb(mz);
+    AsciiCanvas canvas(mz);
+    CellVector dist;
+
+    ansiClear();
+    cout << "Please resize terminal to fit entire maze, then press Enter...\n";
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    ansiClear();
+
+    unordered_set<int> visitedSet;
+    bitBfsDistances(mb, 0, goal, dist, [&](int layer) {
+        unordered_set<int> frontierSet;
+        for (int v = 0; v < W * H; v++) {
+            if (dist[v] == layer) frontierSet.insert(v);
+        }
+        drawFrame(canvas, frontierSet, visitedSet, -1,
+                  "Bit BFS - wavefront layer " + to_string(layer) +
+                  " (" + to_string(frontierSet.size()) + " cells)");
+        visitedSet.insert(frontierSet.begin(), frontierSet.end());
+    });
+
+    drawFinalPath(canvas, parentsFromDistances(mz, dist, goal), goal);
+}
+
+inline int popCount64(uint64_t b) {
+#ifdef _MSC_VER
+    return (int)__popcnt64(b);
+#else
+    return __builtin_popcountll(b);
+#endif
+}
+
+/* ---------- Dead-end filling: one row pass ---------- */
+// Fills, in place, every live cell of row y that has at most one open side
+// leading to a live neighbour, except the kept cells (start and goal). The
+// four side masks are counted bit-sliced, so the "fewer than two" test is
+// a few ANDs/ORs per word instead of a popcount per cell. Au / Ad are the
+// live masks of the rows above and below. Returns the OR of filled bits.
+template<typename O>
+MAZE_INLINE uint64_t deadEndRowWith(
+    uint64_t *A, const uint64_t *Au, const uint64_t *Ad,
+    const uint64_t *R, const uint64_t *D, const uint64_t *keep, int words, int stride
+) {
+    const uint64_t *Du = D - stride;
+    typename O::Vec acc = O::zero();
+    int i = 0;
+    for (; i + O::lanes <= words; i += O::lanes) {
+        auto a = O::load(A + i), rc = O::load(R + i);
+        auto r = O::vand(rc, O::vor(O::template shr<1>(a), O::template shl<63>(O::load(A + i + 1))));
+        auto l = O::vor(O::template shl<1>(O::vand(rc, a)),
+                        O::template shr<63>(O::vand(O::load(R + i - 1), O::load(A + i - 1))));
+        auto d = O::vand(O::load(D + i), O::load(Ad + i));
+        auto u = O::vand(O::load(Du + i), O::load(Au + i));
+        auto two = O::vor(O::vor(O::vand(r, l), O::vand(d, u)),
+                          O::vand(O::vor(r, l), O::vor(d, u)));
+        auto dead = O::andNot(O::vor(two, O::load(keep + i)), a);
+        O::store(A + i, O::andNot(dead, a));
+        acc = O::vor(acc, dead);
+    }
+    uint64_t any = O::orAll(acc);
+    if constexpr (O::lanes > 1)
+        if (i < words) any |= deadEndRowWith<ScalarWords>(A + i, Au + i, Ad + i, R + i, D + i,
+                                                           keep + i, words - i, stride);
+    return any;
+}
+
+/* ---------- Dead-end filling solver ---------- */
+// Repeatedly fills dead ends until only corridors joining start and goal
+// remain; for a perfect maze that is exactly the solution path. Needs no
+// queue, stack or parent array: the only state is one live bit per cell.
+struct DeadEndFill {
+    const MazeBits &mb;
+    WordVector alive, keep;
+    vector<uint64_t> allLive;
+    int passes = 0;
+
+    // Pass the thread count run() will get, so each band's rows are first
+    // touched by the thread that fills them.
+    DeadEndFill(const MazeBits &bits, int startCell, int goalCell, int threads = 1): mb(bits) {
+        alive.resize(mb.openRight.size());
+        keep.resize(mb.openRight.size());
+        allLive.assign(mb.stride, ~0ULL);
+        int H = mb.mazeH;
+        forEachBand(rowBands(threads, H), H, [&](int y0, int y1) {
+            size_t from = mb.rowOffset(y0 == 0 ? -1 : y0) - 1, to = mb.rowOffset(y1 == H ? H + 1 : y1) - 1;
+            fill(alive.begin() + from, alive.begin() + to, 0);
+            fill(keep.begin() + from, keep.begin() + to, 0);
+            for (int y = y0; y < y1; y++) {
+                uint64_t *a = mb.rowOf(alive, y);
+                for (int x = 0; x < mb.mazeW; x++) a[x / 64] |= 1ULL << (x % 64);
+            }
+        });
+        for (int c : { startCell, goalCell }) {
+            Point p = cellPt(c, mb.mazeW);
+            mb.rowOf(keep, p.y)[p.x / 64] |= 1ULL << (p.x % 64);
+        }
+    }
+
+    // Runs rows [y0, y1) to a fixpoint, starting from the rows flagged in
+    // dirty. With sealed set, rows outside the band are taken as all live
+    // and never read, so bands can run on separate threads.
+    template<typename OnPass>
+    void settle(int y0, int y1, vector<char> &dirty, bool sealed, OnPass onPass) {
+        int stride = mb.stride;
+        auto deadEndRow = simdKernels().deadEndRow;
+        bool down = true, any = true;
+        while (any) {
+            any = false;
+            for (int k = 0; k < y1 - y0; k++) {
+                int y = down ? y0 + k : y1 - 1 - k;
+                if (!dirty[y]) continue;
+                dirty[y] = 0;
+                size_t off = mb.rowOffset(y);
+                const uint64_t *au = (sealed && y == y0)     ? allLive.data() + 1 : alive.data() + off - stride;
+                const uint64_t *ad = (sealed && y == y1 - 1) ? allLive.data() + 1 : alive.data() + off + stride;
+                if (!deadEndRow(alive.data() + off, au, ad,
+                                mb.openRight.data() + off, mb.openDown.data() + off,
+                                keep.data() + off, mb.words, stride)) continue;
+                any = true;
+                for (int yy = max(y - 1, y0); yy <= min(y + 1, y1 - 1); yy++) dirty[yy] = 1;
+            }
+            // Alternate sweep direction so fills travel up as fast as down.
+            down = !down;
+            if (any) onPass();
+        }
+    }
+
+    // Fills with one band per thread first, then settles the band seams.
+    template<typename OnPass>
+    void run(int threads, OnPass onPass) {
+        int H = mb.mazeH;
+        threads = rowBands(threads, H);
+        vector<char> dirty(H, 1);
+        if (threads > 1) {
+            forEachBand(threads, H, [this, &dirty](int y0, int y1) { settle(y0, y1, dirty, true, []{}); });
+            fill(dirty.begin(), dirty.end(), 0);
+            for (int t = 0; t < threads; t++) {
+                dirty[H * t / threads] = 1;
+                dirty[H * (t + 1) / threads - 1] = 1;
+            }
+        }
+        settle(0, H, dirty, false, [&]{ passes++; onPass(); });
+    }
+
+    long long liveCells() const {
+        long long n = 0;
+        for (uint64_t w : alive) n += popCount64(w);
+        return n;
+    }
+    bool isLive(int cell) const {
+        Point p = cellPt(cell, mb.mazeW);
+        return (mb.rowOf(alive, p.y)[p.x / 64] >> (p.x % 64)) & 1;
+    }
+};
+
+/* ---------- Dead-end filling (supports skipping animation) ---------- */
+SolveOutcome deadEndOutcome(const DeadEndFill &filler, int N) {
+    vector<int> corridor;
+    for (int v = 0; v < N; v++) {
+        if (filler.isLive(v)) corridor.push_back(v);
+    }
+    return { move(corridor),
+             "FINAL - Dead-end filling: " + to_string(filler.liveCells()) +
+             " corridor cells left, " + to_string(N - filler.liveCells()) + " filled" };
+}
+
+SolveOutcome skipDeadEndFill(const Maze &mz, int threads) {
+    int W = mz.mazeW, H = mz.mazeH;
+    MazeBits mb(mz, threads);
+    DeadEndFill filler(mb, 0, cellId(W-1, H-1, W), threads);
+    filler.run(threads, []{});
+    return deadEndOutcome(filler, W * H);
+}
+
+void runDeadEndFill(const Maze &mz, bool skipAnimation) {
+    if (skipAnimation) {
+        showOutcome(mz, skipDeadEndFill(mz, (int)thread::hardware_concurrency()));
+        return;
+    }
+
+    int W = mz.mazeW, H = mz.mazeH, N = W * H;
+    MazeBits mb(mz);
+    DeadEndFill filler(mb, 0, cellId(W-1, H-1, W));
+    AsciiCanvas canvas(mz);
+
+    ansiClear();
+    cout << "Please resize terminal to fit entire maze, then press Enter...\n";
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    ansiClear();
+
+    unordered_set<int> filledSet;
+    auto onPass = [&]() {
+        unordered_set<int> newlyFilled;
+        for (int v = 0; v < N; v++) {
+            if (!filler.isLive(v) && !filledSet.count(v)) newlyFilled.insert(v);
+        }
+        drawFrame(canvas, newlyFilled, filledSet, -1,
+                  "Dead-end fill - pass " + to_string(filler.passes) + ", filled " +
+                  to_string(newlyFilled.size()) + " cells");
+        filledSet.insert(newlyFilled.begin(), newlyFilled.end());
+    };
+    onPass();
+    filler.run(1, onPass);
+
+    SolveOutcome out = deadEndOutcome(filler, N);
+    drawFinalCells(canvas, out.cells, out.status);
+}
+
+/* ---------- Batch solver for small mazes (up to 64x64) ---------- */
+// A small maze fits one word per row, so a batch keeps row y of every
+// maze side by side and one vector op advances all of them at once.
+// Callers must keep both dimensions at 64 or below.
+struct SmallMaze {
+    int mazeW, mazeH;
+    uint64_t openRight[64], openDown[64];
+
+    SmallMaze(int w, int h): mazeW(w), mazeH(h) {
+        for (int y = 0; y < 64; y++) openRight[y] = openDown[y] = 0;
+    }
+    SmallMaze(const Maze &mz): SmallMaze(mz.mazeW, mz.mazeH) {
+        for (int y = 0; y < mazeH; y++) {
+            for (int x = 0; x < mazeW; x++) {
+                if (mz.canMove(x, y, 1)) openRight[y] |= 1ULL << x;
+                if (mz.canMove(x, y, 2)) openDown[y]  |= 1ULL << x;
+            }
+        }
+    }
+};
+
+// Solves mazes[0 .. O::lanes) together, start (0,0) to goal (W-1,H-1) of
+// each, writing shortest path lengths (-1 if unreachable). Everything
+// lives on the stack: rows -1 and 64 are zero pads.
+template<typename O>
+MAZE_INLINE void solveLanesWith(const SmallMaze *mazes, int count, int *lengths) {
+    const int L = O::lanes;
+    alignas(64) uint64_t R[66][L], D[66][L], F[66][L], V[66][L], Nx[66][L];
+    int goalY[L], rowsUsed = 0;
+    uint64_t goalBit[L];
+    bool done[L];
+
+    for (int y = 0; y < 66; y++) {
+        for (int l = 0; l < L; l++) R[y][l] = D[y][l] = F[y][l] = V[y][l] = 0;
+    }
+    for (int l = 0; l < L; l++) {
+        done[l] = (l >= count);
+        if (done[l]) { goalY[l] = 0; goalBit[l] = 0; continue; }
+        const SmallMaze &m = mazes[l];
+        for (int y = 0; y < m.mazeH; y++) {
+            R[y + 1][l] = m.openRight[y];
+            D[y + 1][l] = m.openDown[y];
+        }
+        F[1][l] = V[1][l] = 1;
+        goalY[l] = m.mazeH;
+        goalBit[l] = 1ULL << (m.mazeW - 1);
+        rowsUsed = max(rowsUsed, m.mazeH);
+        lengths[l] = (m.mazeW == 1 && m.mazeH == 1) ? 0 : -1;
+        done[l] = (lengths[l] == 0);
+    }
+
+    for (int layer = 1; ; layer++) {
+        typename O::Vec any = O::zero();
+        for (int y = 1; y <= rowsUsed; y++) {
+            auto f = O::load(F[y]), r = O::load(R[y]);
+            auto horiz = O::vor(O::template shl<1>(O::vand(f, r)),
+                                O::vand(O::template shr<1>(f), r));
+            auto vert  = O::vor(O::vand(O::load(F[y - 1]), O::load(D[y - 1])),
+                                O::vand(O::load(F[y + 1]), O::load(D[y])));
+            auto nx = O::andNot(O::load(V[y]), O::vor(horiz, vert));
+            O::store(Nx[y], nx);
+            O::store(V[y], O::vor(O::load(V[y]), nx));
+            any = O::vor(any, nx);
+        }
+        bool allDone = true;
+        for (int l = 0; l < L; l++) {
+            if (done[l]) continue;
+            if (V[goalY[l]][l] & goalBit[l]) { lengths[l] = layer; done[l] = true; }
+            else allDone = false;
+        }
+        if (allDone || !O::orAll(any)) return;
+        for (int y = 1; y <= rowsUsed; y++) O::store(F[y], O::load(Nx[y]));
+    }
+}
+
+/* ---------- Runtime SIMD dispatch ---------- */
+// One binary runs on mixed hardware: each kernel is compiled once per
+// instruction set through target attributes, and the widest one the CPU
+// reports through CPUID is picked on first use. MAZE_SIMD=scalar|sse4.2|
+// avx2|avx512 caps the choice (handy for comparing the paths).
+#define MAZE_KERNELS(suffix, Ops)                                                          \
+    uint64_t wavefrontRow##suffix(const uint64_t *f, const uint64_t *R, const uint64_t *D, \
+                                  const uint64_t *V, uint64_t *out, int words, int stride) { \
+        return wavefrontRowWith<Ops>(f, R, D, V, out, words, stride);                     \
+    }                                                                                      \
+    uint64_t deadEndRow##suffix(uint64_t *A, const uint64_t *Au, const uint64_t *Ad,       \
+                                const uint64_t *R, const uint64_t *D, const uint64_t *keep, \
+                                int words, int stride) {                                   \
+        return deadEndRowWith<Ops>(A, Au, Ad, R, D, keep, words, stride);                  \
+    }                                                                                      \
+    void solveLanes##suffix(const SmallMaze *mazes, int count, int *lengths) {             \
+        solveLanesWith<Ops>(mazes, count, lengths);                                        \
+    }
+
+MAZE_KERNELS(Scalar, ScalarWords)
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define MAZE_X86_DISPATCH 1
+  #pragma GCC push_options
+  #pragma GCC target("sse4.2")
+  MAZE_KERNELS(Sse42, VecWords<2>)
+  #pragma GCC pop_options
+  #pragma GCC push_options
+  #pragma GCC target("avx2")
+  MAZE_KERNELS(Avx2, VecWords<4>)
+  #pragma GCC pop_options
+  #pragma GCC push_options
+  #pragma GCC target("avx512f")
+  MAZE_KERNELS(Avx512, VecWords<8>)
+  #pragma GCC pop_options
+#endif
+
+const SimdKernels &simdKernels() {
+    static const SimdKernels table[] = {
+        { "scalar", wavefrontRowScalar, deadEndRowScalar, solveLanesScalar, 1 },
+#ifdef MAZE_X86_DISPATCH
+        { "sse4.2", wavefrontRowSse42,  deadEndRowSse42,  solveLanesSse42,  2 },
+        { "avx2",   wavefrontRowAvx2,   deadEndRowAvx2,   solveLanesAvx2,   4 },
+        { "avx512", wavefrontRowAvx512, deadEndRowAvx512, solveLanesAvx512, 8 },
+#endif
+    };
+    static const SimdKernels &chosen = [&]() -> const SimdKernels & {
+        int level = 0;
+#ifdef MAZE_X86_DISPATCH
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse4.2")) level = 1;
+        if (__builtin_cpu_supports("avx2"))   level = 2;
+        if (__builtin_cpu_supports("avx512f")) level = 3;
+#endif
+        if (const char *cap = getenv("MAZE_SIMD")) {
+            int n = (int)(sizeof table / sizeof table[0]), named = -1;
+            for (int i = 0; i < n; i++) {
+                if (string(cap) == table[i].name) named = i;
+            }
+            if (named >= 0) {
+                level = min(level, named);
+            } else {
+                cerr << "warning: unknown MAZE_SIMD=" << cap << " (expected scalar|sse4.2|avx2|avx512);"
+                     << " using " << table[level].name << "\n";
+            }
+        }
+        return table[level];
+    }();
+    return chosen;
+}
+
+// Solves any number of small mazes, a full vector of them at a time.
+void solveBatch(const vector<SmallMaze> &mazes, vector<int> &lengths) {
+    const SimdKernels &k = simdKernels();
+    lengths.assign(mazes.size(), -1);
+    for (size_t i = 0; i < mazes.size(); i += k.batchLanes) {
+        int count = (int)min((size_t)k.batchLanes, mazes.size() - i);
+        k.solveLanes(&mazes[i], count, &lengths[i]);
+    }
+}
+
+/* ---------- Fixed-size mazes (constexpr generation and solving) ---------- */
+// SplitMix64: small enough to run inside constant evaluation.
+struct SplitMix64 {
+    uint64_t state;
+    constexpr explicit SplitMix64(uint64_t seed): state(seed) {}
+    constexpr uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+    constexpr uint64_t below(uint64_t n) { return next() % n; }
+};
+
+// Same walls as Maze, but with the size in the type: one word per row in a
+// std::array, no heap, and every loop bound known to the compiler. All of
+// it is constexpr, so mazes and their answers can be baked into tables.
+template<int W, int H>
+struct FixedMaze {
+    static_assert(W >= 1 && H >= 1 && W <= 64 && H <= 64, "FixedMaze is limited to 64x64");
+    static constexpr int N = W * H;
+    array<uint64_t, H> openRight{}, openDown{};
+
+    constexpr bool canMove(int x, int y, int dir) const {
+        if (dir == 0) return y > 0 && ((openDown[y - 1] >> x) & 1);
+        if (dir == 1) return (openRight[y] >> x) & 1;
+        if (dir == 2) return (openDown[y] >> x) & 1;
+        if (dir == 3) return x > 0 && ((openRight[y] >> (x - 1)) & 1);
+        return false;
+    }
+
+    // Kruskal over a shuffled edge list, like Maze::generateRandom.
+    constexpr void generateRandom(uint64_t seed) {
+        struct Edge { int cell = 0, dir = 0; };
+        array<Edge, (W - 1) * H + W * (H - 1)> edges{};
+        int E = 0;
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                if (x + 1 < W) edges[E++] = { y * W + x, 1 };
+                if (y + 1 < H) edges[E++] = { y * W + x, 2 };
+            }
+        }
+        SplitMix64 rng(seed);
+        for (int i = E - 1; i > 0; i--) {
+            int j = (int)rng.below((uint64_t)i + 1);
+            Edge t = edges[i]; edges[i] = edges[j]; edges[j] = t;
+        }
+
+        array<int, N> parent{};
+        for (int i = 0; i < N; i++) parent[i] = i;
+        auto findRoot = [&parent](int x) {
+            while (parent[x] != x) x = parent[x] = parent[parent[x]];
+            return x;
+        };
+        for (int y = 0; y < H; y++) openRight[y] = openDown[y] = 0;
+        for (int i = 0; i < E; i++) {
+            int a = edges[i].cell, b = edges[i].dir == 1 ? a + 1 : a + W;
+            int ra = findRoot(a), rb = findRoot(b);
+            if (ra == rb) continue;
+            parent[ra] = rb;
+            if (edges[i].dir == 1) openRight[a / W] |= 1ULL << (a % W);
+            else                   openDown[a / W]  |= 1ULL << (a % W);
+        }
+    }
+
+    // Bitboard BFS from (0,0) to (W-1,H-1); -1 if unreachable.
+    constexpr int shortestPath() const {
+        if (N == 1) return 0;
+        array<uint64_t, H> front{}, seen{}, next{};
+        front[0] = seen[0] = 1;
+        for (int layer = 1; ; layer++) {
+            uint64_t any = 0;
+            for (int y = 0; y < H; y++) {
+                uint64_t f = front[y], r = openRight[y];
+                uint64_t nx = ((f & r) << 1) | ((f >> 1) & r);
+                if (y > 0)     nx |= front[y - 1] & openDown[y - 1];
+                if (y + 1 < H) nx |= front[y + 1] & openDown[y];
+                next[y] = nx & ~seen[y];
+                any |= next[y];
+            }
+            for (int y = 0; y < H; y++) { seen[y] |= next[y]; front[y] = next[y]; }
+            if ((seen[H - 1] >> (W - 1)) & 1) return layer;
+            if (!any) return -1;
+        }
+    }
+
+    // Cells of one shortest path, start first; returns the cell count
+    // (0 if the goal is unreachable).
+    constexpr int solvePath(array<int, N> &path) const {
+        array<int, N> parentOf{}, que{};
+        for (int i = 0; i < N; i++) parentOf[i] = -2;
+        int head = 0, tail = 0;
+        que[tail++] = 0;
+        parentOf[0] = -1;
+        while (head < tail) {
+            int u = que[head++];
+            if (u == N - 1) break;
+            for (int dir = 0; dir < 4; dir++) {
+                int x = u % W, y = u / W;
+                if (!canMove(x, y, dir)) continue;
+                int v = (y + (dir==2) - (dir==0)) * W + x + (dir==1) - (dir==3);
+                if (parentOf[v] != -2) continue;
+                parentOf[v] = u;
+                que[tail++] = v;
+            }
+        }
+        if (parentOf[N - 1] == -2) return 0;
+        int len = 0;
+        for (int v = N - 1; v != -1; v = parentOf[v]) path[len++] = v;
+        for (int i = 0, j = len - 1; i < j; i++, j--) {
+            int t = path[i]; path[i] = path[j]; path[j] = t;
+        }
+        return len;
+    }
+
+    // Row words to and from the batch solver's SmallMaze; no heap either way.
+    static FixedMaze fromSmallMaze(const SmallMaze &sm) {
+        FixedMaze mz;
+        for (int y = 0; y < H; y++) {
+            mz.openRight[y] = sm.openRight[y];
+            mz.openDown[y] = sm.openDown[y];
+        }
+        return mz;
+    }
+    SmallMaze toSmallMaze() const {
+        SmallMaze sm(W, H);
+        for (int y = 0; y < H; y++) {
+            sm.openRight[y] = openRight[y];
+            sm.openDown[y] = openDown[y];
+        }
+        return sm;
+    }
+};
+
+template<int W, int H>
+constexpr FixedMaze<W, H> makeFixedMaze(uint64_t seed) {
+    FixedMaze<W, H> mz;
+    mz.generateRandom(seed);
+    return mz;
+}
+
+// True when solvePath gives shortestPath() + 1 cells from start to goal,
+// each step through an open wall.
+template<int W, int H>
+constexpr bool solvePathIsValid(const FixedMaze<W, H> &mz) {
+    array<int, W * H> path{};
+    int len = mz.solvePath(path);
+    if (len != mz.shortestPath() + 1 || path[0] != 0 || path[len - 1] != W * H - 1) return false;
+    for (int i = 1; i < len; i++) {
+        int u = path[i - 1], v = path[i], x = u % W, y = u / W, dir = -1;
+        if (v == u - W) dir = 0;
+        else if (v == u + 1) dir = 1;
+        else if (v == u + W) dir = 2;
+        else if (v == u - 1) dir = 3;
+        if (dir < 0 || !mz.canMove(x, y, dir)) return false;
+    }
+    return true;
+}
+
+// Generated and solved entirely by the compiler; --batch checks its SIMD
+// kernel against this answer before timing anything.
+constexpr FixedMaze<8, 8> kSampleMaze = makeFixedMaze<8, 8>(2024);
+static_assert(kSampleMaze.shortestPath() > 0, "constexpr maze must be solvable");
+static_assert(solvePathIsValid(kSampleMaze), "constexpr path must walk from start to goal");
+
+// Batch solving on FixedMaze: each maze is copied into stack rows and
+// solved by the fixed-size bitboard BFS, whose loops the compiler unrolls
+// for that W and H. Instantiated for the square sizes below only.
+template<int W, int H>
+void solveFixedBatch(const vector<SmallMaze> &mazes, vector<int> &lengths) {
+    lengths.assign(mazes.size(), -1);
+    for (size_t i = 0; i < mazes.size(); i++)
+        lengths[i] = FixedMaze<W, H>::fromSmallMaze(mazes[i]).shortestPath();
+}
+
+using FixedBatchSolver = void (*)(const vector<SmallMaze> &, vector<int> &);
+FixedBatchSolver fixedBatchSolver(int W, int H) {
+    if (W != H) return nullptr;
+    switch (W) {
+    case 4:  return solveFixedBatch<4, 4>;
+    case 8:  return solveFixedBatch<8, 8>;
+    case 16: return solveFixedBatch<16, 16>;
+    case 32: return solveFixedBatch<32, 32>;
+    }
+    return nullptr;
+}
+
+/* ---------- Concurrent hash set (dedupe) ---------- */
+// Fixed-capacity open addressing over atomics. A key claims its slot with
+// one CAS and is never removed; each key also keeps the lowest id that
+// offered it (atomic min), so which copy of a duplicate wins does not
+// depend on thread timing. Keys are hashes already and index the table
+// directly; key 0 is stored as 1. maxKeys bounds the distinct keys.
+class ConcurrentHashSet {
+public:
+    explicit ConcurrentHashSet(size_t maxKeys) {
+        size_t cap = 16;
+        while (cap < 2 * maxKeys) cap <<= 1;
+        mask = cap - 1;
+        keys.reset(new atomic<uint64_t>[cap]);
+        owners.reset(new atomic<uint64_t>[cap]);
+        for (size_t i = 0; i < cap; i++) {
+            keys[i].store(0, memory_order_relaxed);
+            owners[i].store(UINT64_MAX, memory_order_relaxed);
+        }
+    }
+
+    void offer(uint64_t key, uint64_t id) {
+        atomic<uint64_t> &owner = owners[slotOf(key, true)];
+        uint64_t cur = owner.load(memory_order_relaxed);
+        while (id < cur && !owner.compare_exchange_weak(cur, id, memory_order_relaxed)) {}
+    }
+
+    // Lowest id offered with key, or UINT64_MAX.
+    uint64_t owner(uint64_t key) const {
+        size_t s = const_cast<ConcurrentHashSet *>(this)->slotOf(key, false);
+        return s == SIZE_MAX ? UINT64_MAX : owners[s].load(memory_order_relaxed);
+    }
+
+    size_t size() const { return count.load(); }
+
+private:
+    size_t mask;
+    unique_ptr<atomic<uint64_t>[]> keys, owners;
+    atomic<size_t> count{ 0 };
+
+    size_t slotOf(uint64_t key, bool claim) {
+        if (key == 0) key = 1;
+        for (size_t i = key & mask; ; i = (i + 1) & mask) {
+            uint64_t k = keys[i].load(memory_order_acquire);
+            if (k == key) return i;
+            if (k != 0) continue;
+            if (!claim) return SIZE_MAX;
+            if (keys[i].compare_exchange_strong(k, key, memory_order_acq_rel)) {
+                count.fetch_add(1, memory_order_relaxed);
+                return i;
+            }
+            if (k == key) return i;
+        }
+    }
+};
+
+/* ---------- Batch generation without duplicates ---------- */
+// Generates from seeds SEED, SEED+1, ... in blocks, hashing each maze on
+// worker threads into a ConcurrentHashSet, and keeps a maze only if its
+// seed is the lowest one seen with that hash. The kept set is therefore
+// the first `count` distinct mazes in seed order, whatever the thread
+// count. Tiny sizes have few distinct mazes, so the search gives up
+// after max(16 * count, 65536) seeds. Returns the number of seeds tried.
+uint64_t generateDistinct(int count, int W, int H, unsigned seed, bool symmetric,
+                          vector<SmallMaze> &mazes) {
+    const int BLOCK = 4096;
+    uint64_t maxSeeds = max<uint64_t>(16ULL * count, 65536), tried = 0;
+    int threads = max(1, (int)thread::hardware_concurrency());
+    ConcurrentHashSet seen((size_t)count + BLOCK);
+    vector<uint64_t> keys(BLOCK);
+    vector<unique_ptr<SmallMaze>> block(BLOCK);
+
+    while ((int)mazes.size() < count && tried < maxSeeds) {
+        int n = (int)min<uint64_t>(BLOCK, maxSeeds - tried);
+        atomic<int> next{ 0 };
+        vector<thread> pool;
+        for (int t = 0; t < threads; t++) {
+            pool.emplace_back([&]() {
+                for (int i; (i = next.fetch_add(1)) < n; ) {
+                    Maze mz(W, H);
+                    generateMaze(mz, seed + (unsigned)(tried + i));
+                    keys[i] = symmetric ? canonicalMazeHash(mz) : mazeHash(mz);
+                    seen.offer(keys[i], tried + i);
+                    block[i].reset(new SmallMaze(mz));
+                }
+            });
+        }
+        for (auto &th : pool) th.join();
+        for (int i = 0; i < n && (int)mazes.size() < count; i++) {
+            if (seen.owner(keys[i]) == tried + i) mazes.push_back(*block[i]);
+        }
+        tried += n;
+    }
+    return tried;
+}
+
+/* ---------- Command line: maze arguments ---------- */
+// For commands taking (FILE | W H SEED): an existing file always wins, so
+// a maze saved as 2024.maze is loaded rather than read as a width.
+bool isMazeFileArg(const char *arg) {
+    if (FILE *f = fopen(arg, "rb")) {
+        fclose(f);
+        return true;
+    }
+    return !isdigit((unsigned char)arg[0]);
+}
+
+/* ---------- Command line: batch solve ---------- */
+// maze_demo --batch COUNT W H [SEED [exact | symmetric]]
+// With a dedupe mode the batch holds no two mazes with the same hash
+// (exact) or the same hash up to rotation and mirroring (symmetric).
+// Square batches of 4, 8, 16 or 32 are also solved on FixedMaze.
+int runBatchCommand(int argc, char **argv) {
+    string mode = argc > 6 ? argv[6] : "";
+    if (argc < 5 || (!mode.empty() && mode != "exact" && mode != "symmetric")) {
+        cerr << "usage: " << argv[0] << " --batch COUNT W H [SEED [exact | symmetric]]\n";
+        return 2;
+    }
+    int count = atoi(argv[2]), W = atoi(argv[3]), H = atoi(argv[4]);
+    unsigned seed = (argc > 5) ? (unsigned)strtoul(argv[5], nullptr, 10) : (unsigned)time(NULL);
+    if (count < 1 || W < 1 || H < 1 || W > 64 || H > 64) {
+        cerr << "COUNT must be positive and W, H in 1..64\n";
+        return 2;
+    }
+
+    // Self-check: the batch kernel must agree with the compile-time answer.
+    vector<SmallMaze> sample(1, kSampleMaze.toSmallMaze());
+    vector<int> sampleLength;
+    solveBatch(sample, sampleLength);
+    if (sampleLength[0] != kSampleMaze.shortestPath()) {
+        cerr << simdKernels().name << " kernel solved the built-in 8x8 maze in " << sampleLength[0]
+             << " moves, expected " << kSampleMaze.shortestPath() << "\n";
+        return 1;
+    }
+
+    vector<SmallMaze> mazes;
+    mazes.reserve(count);
+    if (mode.empty()) {
+        for (int i = 0; i < count; i++) {
+            Maze mz(W, H);
+            generateMaze(mz, seed + (unsigned)i);
+            mazes.emplace_back(mz);
+        }
+    } else {
+        auto g0 = chrono::steady_clock::now();
+        uint64_t tried = generateDistinct(count, W, H, seed, mode == "symmetric", mazes);
+        double gsecs = chrono::duration<double>(chrono::steady_clock::now() - g0).count();
+        cout << "kept " << mazes.size() << " distinct mazes (" << mode << ") from " << tried
+             << " seeds in " << gsecs * 1000 << " ms\n";
+        if ((int)mazes.size() < count) {
+            cerr << "only " << mazes.size() << " distinct " << W << "x" << H << " mazes found\n";
+            count = (int)mazes.size();
+        }
+    }
+
+    vector<int> lengths;
+    auto t0 = chrono::steady_clock::now();
+    solveBatch(mazes, lengths);
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    long long total = 0;
+    for (int len : lengths) total += len;
+    cout << "solved " << count << " mazes " << W << "x" << H << " ("
+         << simdKernels().batchLanes << " per batch, " << simdKernels().name << ") in " << secs * 1000 << " ms, "
+         << (long long)(count / max(secs, 1e-9)) << " solves/s, mean path length "
+         << (double)total / count << "\n";
+
+    // Sizes with a FixedMaze instantiation are solved again on it, one maze
+    // at a time, and must agree with the lane kernel.
+    if (FixedBatchSolver fixed = fixedBatchSolver(W, H)) {
+        vector<int> fixedLengths;
+        auto f0 = chrono::steady_clock::now();
+        fixed(mazes, fixedLengths);
+        double fsecs = chrono::duration<double>(chrono::steady_clock::now() - f0).count();
+        if (fixedLengths != lengths) {
+            cerr << "fixed-size " << W << "x" << H << " solver disagrees with the "
+                 << simdKernels().name << " kernel\n";
+            return 1;
+        }
+        cout << "solved " << count << " mazes " << W << "x" << H << " (FixedMaze<" << W << "," << H
+             << ">) in " << fsecs * 1000 << " ms, " << (long long)(count / max(fsecs, 1e-9)) << " solves/s\n";
+    }
+    return 0;
+}
+
+/* ---------- Landmark (ALT) heuristic for A* ---------- */
+// Preprocessing: k landmarks picked by farthest-point selection, with the
+// BFS distance from each one to every cell kept as 32-bit values. By the
+// triangle inequality |d(L,goal) - d(L,v)| never overestimates d(v,goal),
+// and in a maze it is far tighter than the Manhattan bound.
+struct Landmarks {
+    static const uint32_t UNREACHED = UINT32_MAX;
+    int numCells;
+    vector<int> cells;
+    vector<uint32_t, LargePageAllocator<uint32_t>> dist;   // landmark-major: dist[l * numCells + v]
+
+    Landmarks(const Maze &mz, int k): numCells(mz.mazeW * mz.mazeH) {
+        MazeBits mb(mz);
+        k = max(1, min(k, numCells));
+        CellVector d;
+        vector<int> nearest(numCells, INT_MAX);
+        // Seed from the farthest cell from cell 0, then keep taking the cell
+        // farthest from every landmark chosen so far.
+        bitBfsDistances(mb, 0, -1, d, [](int){});
+        int next = (int)(max_element(d.begin(), d.end()) - d.begin());
+        // Sized up front: growing a huge-page block remaps all of it.
+        dist.reserve((size_t)k * numCells);
+        for (int l = 0; l < k; l++) {
+            cells.push_back(next);
+            bitBfsDistances(mb, next, -1, d, [](int){});
+            for (int v = 0; v < numCells; v++) {
+                dist.push_back(d[v] < 0 ? UNREACHED : (uint32_t)d[v]);
+                if (d[v] >= 0) nearest[v] = min(nearest[v], d[v]);
+            }
+            next = 0;
+            for (int v = 0; v < numCells; v++) {
+                if (nearest[v] != INT_MAX && nearest[v] > nearest[next]) next = v;
+            }
+        }
+    }
+};
+
+// Plugs into runPQ through its Heuristic parameter.
+struct AltHeuristic {
+    const Landmarks *lm;
+    int goal;
+
+    int operator()(int v) const {
+        int best = 0, n = lm->numCells;
+        for (size_t l = 0; l < lm->cells.size(); l++) {
+            uint32_t dg = lm->dist[l * n + goal], dv = lm->dist[l * n + v];
+            if (dg == Landmarks::UNREACHED || dv == Landmarks::UNREACHED) continue;
+            best = max(best, abs((int)dg - (int)dv));
+        }
+        return best;
+    }
+};
+
+/* ---------- Anytime A* (ARA*) ---------- */
+// Weighted A* with keys g + eps*h finds a first path quickly; eps is then
+// lowered step by step, reusing the search tree (the cells whose g
+// improved after they were expanded are carried over from INCONS), until
+// the path is provably optimal or the deadline passes. bound is the
+// suboptimality factor proven so far: pathLen <= bound * optimal.
+struct AnytimeResult {
+    bool found = false;
+    int pathLen = -1, iterations = 0;
+    double epsilon = 0, bound = 0;
+    long long expansions = 0;
+    vector<int> parentOf;
+};
+
+template<typename Heuristic, typename OnSolution>
+AnytimeResult runAnytimeAStar(
+    const Maze &mz, Heuristic h, double eps0, double epsStep,
+    chrono::steady_clock::time_point deadline, OnSolution onSolution
+) {
+    int W = mz.mazeW, H = mz.mazeH, N = W * H, goal = cellId(W-1, H-1, W);
+    AnytimeResult res;
+    vector<int> g(N, INT_MAX);
+    vector<char> inOpen(N, 0), inIncons(N, 0);
+    vector<int> closedIter(N, -1), incons;
+    res.parentOf.assign(N, -1);
+
+    struct Entry { double key; int g, cell; };
+    auto later = [](const Entry &a, const Entry &b) { return a.key > b.key; };
+    priority_queue<Entry, vector<Entry>, decltype(later)> open(later);
+
+    double eps = max(1.0, eps0);
+    auto pushOpen = [&](int v) {
+        inOpen[v] = 1;
+        open.push({ g[v] + eps * h(v), g[v], v });
+    };
+    auto dropStale = [&]() {
+        while (!open.empty() && (!inOpen[open.top().cell] || open.top().g != g[open.top().cell]))
+            open.pop();
+    };
+
+    g[0] = 0;
+    pushOpen(0);
+    for (int iter = 0; ; iter++) {
+        // ImprovePath: expand while some open key is below the goal's g.
+        bool timedOut = false;
+        for (dropStale(); !open.empty() && (g[goal] == INT_MAX || open.top().key < g[goal]); dropStale()) {
+            if ((res.expansions & 255) == 0 && chrono::steady_clock::now() >= deadline) {
+                timedOut = true;
+                break;
+            }
+            int u = open.top().cell;
+            open.pop();
+            inOpen[u] = 0;
+            closedIter[u] = iter;
+            res.expansions++;
+
+            Point pu = cellPt(u, W);
+            for (int dir = 0; dir < 4; dir++) {
+                if (!mz.canMove(pu.x, pu.y, dir)) continue;
+                int v = cellId(pu.x + (dir==1) - (dir==3), pu.y + (dir==2) - (dir==0), W);
+                if (g[u] + 1 >= g[v]) continue;
+                g[v] = g[u] + 1;
+                res.parentOf[v] = u;
+                if (closedIter[v] != iter) pushOpen(v);
+                else if (!inIncons[v]) { inIncons[v] = 1; incons.push_back(v); }
+            }
+        }
+        if (g[goal] == INT_MAX) return res;   // deadline hit before any path
+
+        // Every optimal path still has a cell in OPEN or INCONS carrying its
+        // optimal g, so min(g + h) over them is a lower bound at any time.
+        double lower = g[goal];
+        auto scan = open;
+        for (; !scan.empty(); scan.pop()) {
+            const Entry &e = scan.top();
+            if (inOpen[e.cell] && e.g == g[e.cell]) lower = min(lower, (double)e.g + h(e.cell));
+        }
+        for (int v : incons) lower = min(lower, (double)g[v] + h(v));
+
+        double proven = g[goal] / max(lower, 1.0);
+        if (!timedOut) proven = min(proven, eps);   // ImprovePath finished
+        res.bound = res.found ? min(res.bound, proven) : proven;
+        res.found = true;
+        res.pathLen = g[goal];
+        res.epsilon = eps;
+        res.iterations = iter + 1;
+        onSolution(res);
+        if (timedOut || res.bound <= 1.0 || chrono::steady_clock::now() >= deadline) return res;
+
+        // Next round: lower eps, move INCONS into OPEN, rebuild the keys.
+        eps = max(1.0, eps - epsStep);
+        vector<int> carried = move(incons);
+        incons.clear();
+        for (int v : carried) inIncons[v] = 0;
+        vector<int> openCells;
+        for (; !open.empty(); open.pop()) {
+            int v = open.top().cell;
+            if (inOpen[v] && open.top().g == g[v]) openCells.push_back(v);
+        }
+        for (int v : openCells) pushOpen(v);
+        for (int v : carried) pushOpen(v);
+    }
+}
+
+/* ---------- Anytime A* (shows every improved path) ---------- */
+template<typename Heuristic>
+void runAnytime(const Maze &mz, Heuristic h, int deadlineMs, bool skipAnimation) {
+    int W = mz.mazeW, H = mz.mazeH, goal = cellId(W-1, H-1, W);
+    AsciiCanvas canvas(mz);
+    auto status = [](const AnytimeResult &r) {
+        char buf[160];
+        snprintf(buf, sizeof buf, "ARA* - eps %.2f, path %d, within %.3fx of optimal, %lld cells expanded",
+                 r.epsilon, r.pathLen, r.bound, r.expansions);
+        return string(buf);
+    };
+
+    // Improved paths are replayed after the search so that drawing does
+    // not eat into the deadline.
+    vector<pair<string, unordered_set<int>>> rounds;
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(deadlineMs);
+    AnytimeResult res = runAnytimeAStar(mz, h, 3.0, 0.5, deadline, [&](const AnytimeResult &r) {
+        if (skipAnimation) return;
+        unordered_set<int> pathSet;
+        for (int v = goal; v != -1; v = r.parentOf[v]) pathSet.insert(v);
+        rounds.push_back({ status(r), move(pathSet) });
+    });
+
+    if (!skipAnimation) {
+        ansiClear();
+        cout << "Please resize terminal to fit entire maze, then press Enter...\n";
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        ansiClear();
+        for (auto &rd : rounds) drawFrame(canvas, rd.second, {}, -1, rd.first);
+    }
+    if (!res.found) {
+        drawFinalCells(canvas, {}, "FINAL - ARA*: no path before the " +
+                       to_string(deadlineMs) + " ms deadline");
+        return;
+    }
+    drawFinalPath(canvas, res.parentOf, goal, "FINAL (exit found) - " + status(res));
+}
+
+/* ---------- Bidirectional A* (average potential) ---------- */
+// Forward search toward the goal and backward search toward the start,
+// both on the potential p = (hF - hB) / 2, where hF / hB are Manhattan
+// bounds to goal / start. With p shared (negated for the backward side)
+// both searches see the same non-negative reduced edge costs, so the
+// classic bidirectional Dijkstra rule applies: once topF + topB >= mu
+// (best meeting cost found so far, shifted by the potentials, which sum
+// to zero here) no shorter path can exist. Keys are doubled to stay
+// integral: forward 2g + hF - hB, backward 2g + hB - hF.
+// g, parents and closed flags are paged like skipPQ's, so a short query
+// on a huge maze only initialises the pages it reaches.
+struct BidirStats {
+    int pathLen = -1, meet = -1;
+    long long expansions = 0;
+};
+
+template<typename OnExpand>
+BidirStats bidirectionalAStar(const Maze &mz, vector<int> &pathCells, OnExpand onExpand) {
+    int W = mz.mazeW, H = mz.mazeH, N = W * H;
+    int start = 0, goal = cellId(W-1, H-1, W);
+    auto pot = [&](int v) {   // 2p(v) = hF(v) - hB(v)
+        Point p = cellPt(v, W);
+        return (abs(p.x - (W-1)) + abs(p.y - (H-1))) - (p.x + p.y);
+    };
+
+    PagedArray<int> g[2] = { PagedArray<int>(N, INT_MAX), PagedArray<int>(N, INT_MAX) };
+    PagedArray<int> par[2] = { PagedArray<int>(N, -1), PagedArray<int>(N, -1) };
+    PagedArray<uint8_t> closed[2] = { PagedArray<uint8_t>(N, 0), PagedArray<uint8_t>(N, 0) };
+    using P = pair<int,int>;
+    priority_queue<P, vector<P, LargePageAllocator<P>>, greater<P>> pq[2];
+    auto key = [&](int side, int v) { return 2 * g[side][v] + (side == 0 ? pot(v) : -pot(v)); };
+
+    BidirStats st;
+    long long mu = LLONG_MAX;
+    g[0][start] = 0; pq[0].push({ key(0, start), start });
+    g[1][goal]  = 0; pq[1].push({ key(1, goal), goal });
+    if (start == goal) { mu = 0; st.meet = start; }
+
+    while (true) {
+        for (int side = 0; side < 2; side++) {
+            while (!pq[side].empty() && closed[side][pq[side].top().second]) pq[side].pop();
+        }
+        if (pq[0].empty() || pq[1].empty()) break;
+        if (mu != LLONG_MAX && (long long)pq[0].top().first + pq[1].top().first >= 2 * mu) break;
+
+        int side = pq[0].top().first <= pq[1].top().first ? 0 : 1;
+        int u = pq[side].top().second;
+        pq[side].pop();
+        closed[side][u] = 1;
+        st.expansions++;
+        onExpand(u, side);
+
+        Point pu = cellPt(u, W);
+        for (int dir = 0; dir < 4; dir++) {
+            if (!mz.canMove(pu.x, pu.y, dir)) continue;
+            int v = cellId(pu.x + (dir==1) - (dir==3), pu.y + (dir==2) - (dir==0), W);
+            if (g[side][u] + 1 >= g[side][v]) continue;
+            g[side][v] = g[side][u] + 1;
+            par[side][v] = u;
+            pq[side].push({ key(side, v), v });
+            if (g[1 - side][v] != INT_MAX && (long long)g[0][v] + g[1][v] < mu) {
+                mu = (long long)g[0][v] + g[1][v];
+                st.meet = v;
+            }
+        }
+    }
+    if (st.meet == -1) return st;
+
+    // Stitch the two half paths at the meeting cell, goal first like
+    // pathCellsFrom.
+    pathCells.clear();
+    for (int v = st.meet; v != goal; ) pathCells.push_back(v = par[1][v]);
+    reverse(pathCells.begin(), pathCells.end());
+    for (int v = st.meet; v != -1; v = par[0][v]) pathCells.push_back(v);
+    st.pathLen = (int)mu;
+    return st;
+}
+
+/* ---------- Bidirectional A* (supports skipping animation) ---------- */
+SolveOutcome bidirOutcome(const BidirStats &st, const vector<int> &pathCells) {
+    if (st.meet == -1) return { {}, "FINAL - Bidirectional A*: no path" };
+    return { pathCells,
+             "FINAL (exit found) - Bidirectional A*: path " + to_string(st.pathLen) +
+             ", " + to_string(st.expansions) + " cells expanded" };
+}
+
+SolveOutcome skipBidirectional(const Maze &mz) {
+    vector<int> pathCells;
+    BidirStats st = bidirectionalAStar(mz, pathCells, [](int, int){});
+    return bidirOutcome(st, pathCells);
+}
+
+void runBidirectional(const Maze &mz, bool skipAnimation) {
+    if (skipAnimation) {
+        showOutcome(mz, skipBidirectional(mz));
+        return;
+    }
+
+    int W = mz.mazeW;
+    AsciiCanvas canvas(mz);
+    vector<int> pathCells;
+    unordered_set<int> visitedSet;
+
+    ansiClear();
+    cout << "Please resize terminal to fit entire maze, then press Enter...\n";
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    ansiClear();
+    BidirStats st = bidirectionalAStar(mz, pathCells, [&](int u, int side) {
+        visitedSet.insert(u);
+        Point p = cellPt(u, W);
+        drawFrame(canvas, {}, visitedSet, u, string("Bidirectional A* - ") +
+                  (side == 0 ? "forward" : "backward") + " expands (" +
+                  to_string(p.x) + "," + to_string(p.y) + ")");
+    });
+
+    SolveOutcome out = bidirOutcome(st, pathCells);
+    drawFinalCells(canvas, out.cells, out.status);
+}
+
+/* ---------- Lock-free MPSC queue ---------- */
+// Vyukov's intrusive-stub queue: producers swing `head` with one atomic
+// exchange, the single consumer walks `tail`. pop() may briefly miss an
+// item whose producer is between its two steps; it shows up next call.
+template<typename T>
+class MpscQueue {
+    struct Node {
+        atomic<Node*> next{ nullptr };
+        T value{};
+    };
+    atomic<Node*> head;
+    Node *tail;
+
+public:
+    MpscQueue() { tail = new Node(); head.store(tail); }
+    ~MpscQueue() {
+        for (Node *n = tail; n; ) { Node *next = n->next.load(); delete n; n = next; }
+    }
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    void push(T value) {
+        Node *n = new Node();
+        n->value = move(value);
+        Node *prev = head.exchange(n, memory_order_acq_rel);
+        prev->next.store(n, memory_order_release);
+    }
+    bool pop(T &out) {
+        Node *next = tail->next.load(memory_order_acquire);
+        if (!next) return false;
+        out = move(next->value);
+        delete tail;
+        tail = next;
+        return true;
+    }
+};
+
+/* ---------- Hash-distributed parallel A* (HDA*) ---------- */
+// Each cell belongs to the thread picked by a hash of its id; only that
+// thread touches its g and parent, so the shared arrays need no locks.
+// Successors travel to their owner in batches over MPSC queues. Open
+// entries, in-flight messages and buffered messages are all "units" in
+// one global counter; a thread publishes the net change it made (new
+// children minus retired entries) before sending, so the counter can only
+// reach zero once no work is left anywhere. Nodes whose f reaches the
+// incumbent path length are pruned, which keeps the answer optimal.
+struct HdaResult {
+    int pathLen = -1;
+    long long expansions = 0, messages = 0;
+    vector<long long> perThread;
+    vector<int> parentOf;
+};
+
+struct HdaMessage { int cell, g, parent; };
+
+template<typename Heuristic>
+HdaResult runHdaStar(const Maze &mz, Heuristic h, int threads) {
+    int W = mz.mazeW, H = mz.mazeH, N = W * H, goal = cellId(W-1, H-1, W);
+    threads = max(1, threads);
+    const int BATCH = 64;
+
+    HdaResult res;
+    vector<int> g(N, INT_MAX);
+    res.parentOf.assign(N, -1);
+    res.perThread.assign(threads, 0);
+    vector<MpscQueue<vector<HdaMessage>>> inbox(threads);
+    atomic<long long> units{ 1 }, messages{ 0 };
+    atomic<int> best{ INT_MAX };
+    auto ownerOf = [threads](int v) {
+        return (int)((((uint32_t)v * 2654435761u) >> 8) % (uint32_t)threads);
+    };
+    inbox[ownerOf(0)].push({ { 0, 0, -1 } });
+
+    auto worker = [&](int self) {
+        using E = pair<int, pair<int,int>>;   // (f, (g, cell))
+        priority_queue<E, vector<E>, greater<E>> open;
+        vector<vector<HdaMessage>> outbox(threads);
+        long long delta = 0, sent = 0, expanded = 0;
+
+        auto accept = [&](const HdaMessage &m) {
+            if (m.g < g[m.cell]) {
+                g[m.cell] = m.g;
+                res.parentOf[m.cell] = m.parent;
+                open.push({ m.g + h(m.cell), { m.g, m.cell } });
+            } else {
+                delta--;
+            }
+        };
+        auto flush = [&]() {
+            // Publish first so the counter never undercounts what is sent.
+            if (delta) { units.fetch_add(delta); delta = 0; }
+            for (int t = 0; t < threads; t++) {
+                if (outbox[t].empty()) continue;
+                sent += (long long)outbox[t].size();
+                inbox[t].push(move(outbox[t]));
+                outbox[t].clear();
+            }
+        };
+
+        vector<HdaMessage> batch;
+        while (true) {
+            while (inbox[self].pop(batch)) {
+                for (const HdaMessage &m : batch) accept(m);
+            }
+            if (open.empty()) {
+                flush();
+                if (units.load() == 0) break;
+                this_thread::yield();
+                continue;
+            }
+
+            E top = open.top();
+            open.pop();
+            int f = top.first, gu = top.second.first, u = top.second.second;
+            delta--;
+            if (gu != g[u] || f >= best.load(memory_order_relaxed)) continue;
+            if (u == goal) {
+                for (int b = best.load(); gu < b && !best.compare_exchange_weak(b, gu); ) {}
+                continue;
+            }
+            expanded++;
+            Point pu = cellPt(u, W);
+            for (int dir = 0; dir < 4; dir++) {
+                if (!mz.canMove(pu.x, pu.y, dir)) continue;
+                int v = cellId(pu.x + (dir==1) - (dir==3), pu.y + (dir==2) - (dir==0), W);
+                if (gu + 1 + h(v) >= best.load(memory_order_relaxed)) continue;
+                delta++;
+                int owner = ownerOf(v);
+                if (owner == self) accept({ v, gu + 1, u });
+                else outbox[owner].push_back({ v, gu + 1, u });
+            }
+            if ((expanded & (BATCH - 1)) == 0) flush();
+        }
+        res.perThread[self] = expanded;
+        messages.fetch_add(sent);
+    };
+
+    vector<thread> pool;
+    for (int t = 0; t < threads; t++) pool.emplace_back(worker, t);
+    for (auto &th : pool) th.join();
+
+    for (long long e : res.perThread) res.expansions += e;
+    res.messages = messages.load();
+    if (best.load() != INT_MAX) res.pathLen = best.load();
+    return res;
+}
+
+/* ---------- HDA* (final path and per-thread counts) ---------- */
+template<typename Heuristic>
+void runParallelAStar(const Maze &mz, Heuristic h) {
+    int W = mz.mazeW, H = mz.mazeH, goal = cellId(W-1, H-1, W);
+    int threads = max(2, (int)thread::hardware_concurrency());
+    auto t0 = chrono::steady_clock::now();
+    HdaResult res = runHdaStar(mz, h, threads);
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+
+    AsciiCanvas canvas(mz);
+    if (res.pathLen < 0) {
+        drawFinalCells(canvas, {}, "FINAL - HDA*: no path");
+        return;
+    }
+    string split;
+    for (long long e : res.perThread) split += (split.empty() ? "" : "/") + to_string(e);
+    char buf[64];
+    snprintf(buf, sizeof buf, "%.2f ms", ms);
+    drawFinalPath(canvas, res.parentOf, goal,
+                  "FINAL (exit found) - HDA* on " + to_string(threads) + " threads: path " +
+                  to_string(res.pathLen) + ", expanded " + split + ", " +
+                  to_string(res.messages) + " messages, " + buf);
+}
+
+/* ---------- Race mode: DFS, BFS, Dijkstra and A* side by side ---------- */
+// Every solver runs on its own thread against the shared read-only Maze
+// and publishes cell states through relaxed atomics; the main thread
+// composites one tile per solver. Reported times leave out the per-step
+// animation throttle, so they compare the algorithms rather than the delay.
+enum RaceCell : uint8_t { RACE_NONE, RACE_FRONTIER, RACE_VISITED, RACE_PATH };
+
+struct RaceLane {
+    string name;
+    vector<atomic<uint8_t>> state;
+    vector<int> pathCells;
+    atomic<int> current{ -1 };
+    atomic<long long> expansions{ 0 };
+    atomic<bool> done{ false };
+    int pathLen = -1;
+    double ms = 0;
+
+    RaceLane(const string &nm, int N) : name(nm), state(N) {
+        for (auto &s : state) s.store(RACE_NONE, memory_order_relaxed);
+    }
+};
+
+// --solve and race mode number the classic solvers 0-3: DFS, BFS,
+// Dijkstra and A* with the Manhattan heuristic.
+template<typename OnDiscover, typename OnExpand>
+SolveOutcome skipClassic(const Maze &mz, int algo, OnDiscover onDiscover, OnExpand onExpand) {
+    int W = mz.mazeW, H = mz.mazeH;
+    auto manH = [&](int v) {
+        Point p = cellPt(v, W);
+        return (W - 1 - p.x) + (H - 1 - p.y);
+    };
+    switch (algo) {
+        case 0:  return skipDFS(mz, onDiscover, onExpand);
+        case 1:  return skipBFS(mz, onDiscover, onExpand);
+        case 2:  return skipPQ(mz, [](int){ return 0; }, "Dijkstra", onDiscover, onExpand);
+        default: return skipPQ(mz, manH, "A*", onDiscover, onExpand);
+    }
+}
+
+// Tiles go in one row when the terminal is wide enough, otherwise 2x2.
+void drawRaceFrame(const AsciiCanvas &canvas, vector<unique_ptr<RaceLane>> &lanes,
+                   const string &title) {
+    const int GAP = 2, n = (int)lanes.size();
+    int perRow;
+    while (true) {
+        auto sz = getTerminalSize();
+        int t_rows = sz.first, t_cols = sz.second;
+        perRow = n;
+        if (t_cols < n * canvas.cols + (n - 1) * GAP) perRow = (n + 1) / 2;
+        int tileRows = (n + perRow - 1) / perRow;
+        int need_cols = perRow * canvas.cols + (perRow - 1) * GAP;
+        int need_rows = 1 + tileRows * (canvas.rows + 1);
+        if (t_rows >= need_rows && t_cols >= need_cols) break;
+        ansiClear();
+        cout << "Terminal too small. Please resize to at least "
+             << need_cols << "x" << need_rows << ".\n";
+        this_thread::sleep_for(chrono::milliseconds(200));
+    }
+
+    vector<vector<string>> grids;
+    for (auto &lane : lanes) {
+        vector<string> grid = canvas.baseGrid;
+        for (int v = 0; v < (int)lane->state.size(); v++) {
+            uint8_t s = lane->state[v].load(memory_order_relaxed);
+            if (s == RACE_NONE) continue;
+            Point p = cellPt(v, canvas.mazeW);
+            grid[2*p.y + 1][2*p.x + 1] = s == RACE_FRONTIER ? 'o' : s == RACE_VISITED ? '.' : '*';
+        }
+        int cur = lane->current.load(memory_order_relaxed);
+        if (cur != -1 && !lane->done.load()) {
+            Point p = cellPt(cur, canvas.mazeW);
+            grid[2*p.y + 1][2*p.x + 1] = '@';
+        }
+        grids.push_back(move(grid));
+    }
+
+    ansiHome();
+    cout << "\x1b[2K" << title << "\n";
+    for (int first = 0; first < n; first += perRow) {
+        int last = min(n, first + perRow);
+        for (int i = first; i < last; i++) {
+            string label = lanes[i]->name + ": " + to_string(lanes[i]->expansions.load()) +
+                           (lanes[i]->done.load() ? " (done)" : "");
+            label.resize(canvas.cols, ' ');
+            cout << label << (i + 1 < last ? string(GAP, ' ') : "\x1b[K\n");
+        }
+        for (int r = 0; r < canvas.rows; r++) {
+            for (int i = first; i < last; i++) {
+                for (char ch : grids[i][r]) {
+                    switch (ch) {
+                        case '+': cout << COLOR_CORNER << ch << COLOR_RESET; break;
+                        case '-': cout << COLOR_HORIZ  << ch << COLOR_RESET; break;
+                        case '|': cout << COLOR_VERT   << ch << COLOR_RESET; break;
+                        case '.': cout << COLOR_VISIT  << ch << COLOR_RESET; break;
+                        case 'o': cout << COLOR_FRONT  << ch << COLOR_RESET; break;
+                        case '@': cout << COLOR_CUR    << ch << COLOR_RESET; break;
+                        case '*': cout << COLOR_PATH   << ch << COLOR_RESET; break;
+                        default:  cout << ch;
+                    }
+                }
+                cout << (i + 1 < last ? string(GAP, ' ') : "\n");
+            }
+        }
+    }
+    cout.flush();
+}
+
+void runRace(const Maze &mz, bool skipAnimation) {
+    int N = mz.mazeW * mz.mazeH;
+    const char *names[] = { "DFS", "BFS", "Dijkstra", "A*" };
+    vector<unique_ptr<RaceLane>> lanes;
+    for (const char *nm : names) lanes.emplace_back(new RaceLane(nm, N));
+    int stepDelay = skipAnimation ? 0 : g_delayMs;
+
+    AsciiCanvas canvas(mz);
+    if (!skipAnimation) {
+        ansiClear();
+        cout << "Please resize terminal to fit all four mazes, then press Enter...\n";
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        ansiClear();
+    }
+
+    vector<thread> pool;
+    for (int algo = 0; algo < (int)lanes.size(); algo++) {
+        pool.emplace_back([&, algo]() {
+            RaceLane &lane = *lanes[algo];
+            auto t0 = chrono::steady_clock::now();
+            chrono::steady_clock::duration throttled{};
+            SolveOutcome out = skipClassic(mz, algo,
+                [&](int v) { lane.state[v].store(RACE_FRONTIER, memory_order_relaxed); },
+                [&](int u) {
+                    lane.state[u].store(RACE_VISITED, memory_order_relaxed);
+                    lane.current.store(u, memory_order_relaxed);
+                    lane.expansions.fetch_add(1, memory_order_relaxed);
+                    if (stepDelay > 0) {
+                        auto s0 = chrono::steady_clock::now();
+                        this_thread::sleep_for(chrono::milliseconds(stepDelay));
+                        throttled += chrono::steady_clock::now() - s0;
+                    }
+                });
+            lane.ms = chrono::duration<double, milli>(
+                chrono::steady_clock::now() - t0 - throttled).count();
+            lane.pathCells = move(out.cells);
+            lane.pathLen = (int)lane.pathCells.size() - 1;
+            lane.done.store(true);
+        });
+    }
+
+    auto allDone = [&]() {
+        for (auto &lane : lanes) if (!lane->done.load()) return false;
+        return true;
+    };
+    while (!skipAnimation && !allDone()) {
+        drawRaceFrame(canvas, lanes, "RACE - DFS, BFS, Dijkstra and A* on the same maze");
+        this_thread::sleep_for(chrono::milliseconds(max(30, g_delayMs)));
+    }
+    for (auto &th : pool) th.join();
+
+    for (auto &lane : lanes) {
+        for (int v : lane->pathCells) lane->state[v].store(RACE_PATH, memory_order_relaxed);
+    }
+    if (skipAnimation) ansiClear();
+    drawRaceFrame(canvas, lanes, "FINAL - race results");
+    cout << "\n";
+    for (auto &lane : lanes) {
+        char buf[96];
+        snprintf(buf, sizeof buf, "%-9s expanded %8lld   path %6d   %9.3f ms\n",
+                 lane->name.c_str(), lane->expansions.load(), lane->pathLen, lane->ms);
+        cout << buf;
+    }
+    this_thread::sleep_for(chrono::seconds(2));
+}
+
+/* ---------- Command line: save a packed maze ---------- */
+int runSaveCommand(int argc, char **argv) {
+    if (argc < 5) {
+        cerr << "usage: " << argv[0] << " --save FILE W H [SEED]\n";
+        return 2;
+    }
+    int W = atoi(argv[3]), H = atoi(argv[4]);
+    unsigned seed = (argc > 5) ? (unsigned)strtoul(argv[5], nullptr, 10) : (unsigned)time(NULL);
+    if (W < 1 || H < 1) {
+        cerr << "W and H must be positive\n";
+        return 2;
+    }
+    // MAZE_CHECKPOINT=PATH keeps generation progress in PATH.gen.
+    const char *checkpoint = getenv("MAZE_CHECKPOINT");
+    Maze mz(W, H);
+    string err;
+    if (!checkpoint) mz.generateRandom(seed);
+    else if (!mz.generateRandom(seed, string(checkpoint) + ".gen", err)) {
+        cerr << err << "\n";
+        return 1;
+    }
+    braidIfAsked(mz, seed);
+    if (!saveMazeFile(argv[2], mz)) {
+        cerr << "cannot write " << argv[2] << "\n";
+        return 1;
+    }
+    cout << "saved " << W << "x" << H << " maze (seed " << seed << ") to " << argv[2] << "\n";
+    return 0;
+}
+
+#ifndef _WIN32
+/* ---------- Query server over a UNIX socket ---------- */
+// Wire format, native byte order. A request is a QueryHeader and `count`
+// QueryPairs; the reply is a ReplyHeader and `payloadWords` 32-bit words:
+//   OP_DISTANCE  one int32 per pair (-1 when unreachable or out of range)
+//   OP_PATH      per pair a length n, then n cell ids (y * width + x)
+//   OP_STATS     a QueryStats (count must be 0; otherwise the request is
+//                rejected and the connection closed)
+// Mazes past INT32_MAX cells use 64-bit ids: every distance, length and
+// cell id then takes two words, low word first.
+// A connection may send any number of requests; each one is a batch.
+static const uint32_t QUERY_MAGIC = 0x31515A4D;     // "MZQ1"
+static const uint32_t QUERY_MAX_BATCH = 1u << 16;
+enum QueryOp : uint16_t { OP_DISTANCE = 1, OP_PATH = 2, OP_STATS = 3 };
+enum QueryStatus : uint32_t { QUERY_OK = 0, QUERY_BAD_REQUEST = 1 };
+
+struct QueryHeader { uint32_t magic; uint16_t op, flags; uint32_t count; };
+struct QueryPair { uint32_t fromX, fromY, toX, toY; };
+struct ReplyHeader { uint32_t magic, status, width, height, count, payloadWords; };
+struct QueryStats {
+    uint64_t queries, batches, connections, uptimeUs;
+    uint64_t p50Ns, p99Ns, p999Ns, maxNs;
+};
+
+static bool readFull(int fd, void *buf, size_t n) {
+    char *p = (char *)buf;
+    while (n > 0) {
+        ssize_t r = read(fd, p, n);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        p += r;
+        n -= (size_t)r;
+    }
+    return true;
+}
+
+static bool writeFull(int fd, const void *buf, size_t n) {
+    const char *p = (const char *)buf;
+    while (n > 0) {
+        ssize_t r = send(fd, p, n, MSG_NOSIGNAL);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        p += r;
+        n -= (size_t)r;
+    }
+    return true;
+}
+
+// Log-linear buckets: 8 per power of two, so percentiles are read back
+// within 12.5%. Relaxed counters; each worker owns one histogram.
+struct LatencyHistogram {
+    static const int SUB = 8, BUCKETS = 64 * SUB;
+    array<atomic<uint64_t>, BUCKETS> counts;
+
+    LatencyHistogram() { for (auto &c : counts) c.store(0, memory_order_relaxed); }
+
+    static int bucketOf(uint64_t ns) {
+        if (ns < (uint64_t)SUB) return (int)ns;
+        int e = 63 - __builtin_clzll(ns);
+        return (e - 2) * SUB + (int)((ns >> (e - 3)) & (SUB - 1));
+    }
+    static uint64_t upperOf(int b) {
+        if (b < SUB) return (uint64_t)b;
+        int e = b / SUB + 2;
+        return ((uint64_t)(SUB + b % SUB + 1) << (e - 3)) - 1;
+    }
+    void record(uint64_t ns) { counts[bucketOf(ns)].fetch_add(1, memory_order_relaxed); }
+};
+
+static volatile sig_atomic_t g_serverStop = 0;
+static void onServerSignal(int) { g_serverStop = 1; }
+
+struct QueryServer {
+    const MazeView &mz;
+    int threads;
+    chrono::steady_clock::time_point started = chrono::steady_clock::now();
+    atomic<uint64_t> connections{ 0 };
+
+    struct WorkerStats {
+        LatencyHistogram latency;
+        atomic<uint64_t> queries{ 0 }, batches{ 0 };
+    };
+    vector<unique_ptr<WorkerStats>> stats;
+
+    // Work is queued per request, not per connection. Idle connections sit
+    // in the accept thread's poll set; one that turns readable is queued,
+    // a worker reads and answers that single request, then hands the fd
+    // back (waking the poll through wakePipe). Long-lived clients never pin
+    // a worker between requests.
+    mutex mu;
+    condition_variable cv;
+    deque<int> pending;      // connections with a request waiting
+    vector<int> returned;    // answered, to be watched again
+    int wakePipe[2] = { -1, -1 };
+    bool stopping = false;
+
+    QueryServer(const MazeView &m, int t) : mz(m), threads(t) {
+        for (int i = 0; i < threads; i++) stats.emplace_back(new WorkerStats());
+    }
+
+    QueryStats snapshot() {
+        QueryStats s;
+        memset(&s, 0, sizeof s);
+        vector<uint64_t> merged(LatencyHistogram::BUCKETS, 0);
+        for (auto &w : stats) {
+            s.queries += w->queries.load(memory_order_relaxed);
+            s.batches += w->batches.load(memory_order_relaxed);
+            for (int b = 0; b < LatencyHistogram::BUCKETS; b++)
+                merged[b] += w->latency.counts[b].load(memory_order_relaxed);
+        }
+        s.connections = connections.load();
+        s.uptimeUs = (uint64_t)chrono::duration_cast<chrono::microseconds>(
+            chrono::steady_clock::now() - started).count();
+
+        uint64_t total = accumulate(merged.begin(), merged.end(), (uint64_t)0), seen = 0;
+        uint64_t *targets[] = { &s.p50Ns, &s.p99Ns, &s.p999Ns };
+        const double quantiles[] = { 0.5, 0.99, 0.999 };
+        int next = 0;
+        for (int b = 0; b < LatencyHistogram::BUCKETS && total > 0; b++) {
+            if (merged[b] == 0) continue;
+            seen += merged[b];
+            while (next < 3 && seen >= (uint64_t)ceil(quantiles[next] * total))
+                *targets[next++] = LatencyHistogram::upperOf(b);
+            s.maxNs = LatencyHistogram::upperOf(b);
+        }
+        return s;
+    }
+
+    template<typename Index>
+    static void putValue(vector<uint32_t> &out, Index value) {
+        out.push_back((uint32_t)value);
+        if (sizeof(Index) > 4) out.push_back((uint32_t)((uint64_t)value >> 32));
+    }
+
+    // Answers one batch into `out` (reply header first); false on a bad request.
+    template<typename Index>
+    bool answer(const QueryHeader &q, const vector<QueryPair> &pairs,
+                BasicPathScratch<Index> &scratch, WorkerStats &ws, vector<uint32_t> &out) {
+        const size_t HDR = sizeof(ReplyHeader) / sizeof(uint32_t);
+        out.assign(HDR, 0);
+        ReplyHeader rh = { QUERY_MAGIC, QUERY_OK, (uint32_t)mz.mazeW, (uint32_t)mz.mazeH,
+                           q.op == OP_STATS ? 0 : q.count, 0 };
+
+        if (q.op == OP_STATS) {
+            QueryStats s = snapshot();
+            out.resize(HDR + sizeof s / sizeof(uint32_t));
+            memcpy(out.data() + HDR, &s, sizeof s);
+        } else if (q.op == OP_DISTANCE || q.op == OP_PATH) {
+            for (const QueryPair &p : pairs) {
+                auto t0 = chrono::steady_clock::now();
+                bool inside = p.fromX < (uint32_t)mz.mazeW && p.toX < (uint32_t)mz.mazeW &&
+                              p.fromY < (uint32_t)mz.mazeH && p.toY < (uint32_t)mz.mazeH;
+                // Coordinates become cell ids only once they are known to be in range.
+                Index to = -1, d = -1;
+                if (inside) {
+                    to = cellIndex<Index>((int)p.toX, (int)p.toY, mz.mazeW);
+                    d = scratch.search(mz, cellIndex<Index>((int)p.fromX, (int)p.fromY, mz.mazeW), to);
+                }
+                if (q.op == OP_DISTANCE) {
+                    putValue(out, d);
+                } else {
+                    putValue(out, d < 0 ? Index(0) : d + 1);
+                    size_t at = out.size();
+                    out.resize(at + (d < 0 ? 0 : (size_t)(d + 1) * (sizeof(Index) / 4)));
+                    size_t end = out.size();
+                    for (Index v = d < 0 ? -1 : to; v != -1; v = scratch.parent[v]) {
+                        if (sizeof(Index) > 4) out[--end] = (uint32_t)((uint64_t)v >> 32);
+                        out[--end] = (uint32_t)v;
+                    }
+                }
+                ws.latency.record((uint64_t)chrono::duration_cast<chrono::nanoseconds>(
+                    chrono::steady_clock::now() - t0).count());
+            }
+            ws.queries.fetch_add(pairs.size(), memory_order_relaxed);
+        } else {
+            rh.status = QUERY_BAD_REQUEST;
+        }
+        ws.batches.fetch_add(1, memory_order_relaxed);
+        rh.payloadWords = (uint32_t)(out.size() - HDR);
+        memcpy(out.data(), &rh, sizeof rh);
+        return rh.status == QUERY_OK;
+    }
+
+    // Reads and answers one request; false when the connection should close.
+    template<typename Index>
+    bool serveRequest(int fd, BasicPathScratch<Index> &scratch, WorkerStats &ws,
+                      vector<QueryPair> &pairs, vector<uint32_t> &out) {
+        QueryHeader q;
+        if (!readFull(fd, &q, sizeof q)) return false;
+        // A STATS request carrying pairs is malformed: its payload would be
+        // left in the socket and read as the next header.
+        if (q.magic != QUERY_MAGIC || q.count > QUERY_MAX_BATCH || (q.op == OP_STATS && q.count != 0)) {
+            ReplyHeader rh = { QUERY_MAGIC, QUERY_BAD_REQUEST, (uint32_t)mz.mazeW, (uint32_t)mz.mazeH, 0, 0 };
+            writeFull(fd, &rh, sizeof rh);
+            return false;
+        }
+        pairs.resize(q.count);
+        if (!pairs.empty() && !readFull(fd, pairs.data(), pairs.size() * sizeof(QueryPair))) return false;
+        answer(q, pairs, scratch, ws, out);
+        return writeFull(fd, out.data(), out.size() * sizeof(uint32_t));
+    }
+
+    template<typename Index>
+    void worker(int id) {
+        // Pin worker i to CPU i so its scratch arrays stay in that core's caches.
+        pinThreadToCpu(id);
+        BasicPathScratch<Index> scratch((Index)mz.mazeW * mz.mazeH);
+        vector<QueryPair> pairs;
+        vector<uint32_t> out;
+        while (true) {
+            int fd;
+            {
+                unique_lock<mutex> lock(mu);
+                cv.wait(lock, [&] { return stopping || !pending.empty(); });
+                if (pending.empty()) return;
+                fd = pending.front();
+                pending.pop_front();
+            }
+            if (!serveRequest(fd, scratch, *stats[id], pairs, out)) {
+                close(fd);
+                continue;
+            }
+            lock_guard<mutex> lock(mu);
+            returned.push_back(fd);
+            char wake = 1;
+            ssize_t woke = write(wakePipe[1], &wake, 1);   // fails only if a wake is already pending
+            (void)woke;
+        }
+    }
+
+    int run(const string &socketPath) {
+        int lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof addr);
+        addr.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof addr.sun_path) {
+            cerr << "socket path too long\n";
+            return 2;
+        }
+        strcpy(addr.sun_path, socketPath.c_str());
+        unlink(socketPath.c_str());
+        if (lfd < 0 || ::bind(lfd, (sockaddr *)&addr, sizeof addr) != 0 || listen(lfd, 128) != 0) {
+            cerr << "cannot listen on " << socketPath << ": " << strerror(errno) << "\n";
+            if (lfd >= 0) close(lfd);
+            return 1;
+        }
+
+        if (pipe(wakePipe) != 0) {
+            cerr << "cannot create wake pipe: " << strerror(errno) << "\n";
+            close(lfd);
+            return 1;
+        }
+        fcntl(wakePipe[0], F_SETFL, O_NONBLOCK);
+        fcntl(wakePipe[1], F_SETFL, O_NONBLOCK);
+
+        signal(SIGINT, onServerSignal);
+        signal(SIGTERM, onServerSignal);
+        signal(SIGPIPE, SIG_IGN);
+        vector<thread> pool;
+        bool wide = needsWideIndex(mz.mazeW, mz.mazeH);
+        for (int i = 0; i < threads; i++)
+            pool.emplace_back(wide ? &QueryServer::worker<int64_t> : &QueryServer::worker<int>, this, i);
+        cout << "serving " << mz.mazeW << "x" << mz.mazeH << " maze on " << socketPath
+             << " with " << threads << " workers\n" << flush;
+
+        // A client that stalls mid-request holds its worker for at most this long.
+        timeval readTimeout = { 5, 0 };
+        vector<int> idle, ready;
+        vector<pollfd> pfds;
+        while (!g_serverStop) {
+            {
+                lock_guard<mutex> lock(mu);
+                idle.insert(idle.end(), returned.begin(), returned.end());
+                returned.clear();
+            }
+            pfds.assign({ { lfd, POLLIN, 0 }, { wakePipe[0], POLLIN, 0 } });
+            for (int fd : idle) pfds.push_back({ fd, POLLIN, 0 });
+            if (poll(pfds.data(), pfds.size(), 200) <= 0) continue;
+
+            if (pfds[1].revents) {
+                char drain[64];
+                while (read(wakePipe[0], drain, sizeof drain) > 0) {}
+            }
+            idle.clear();
+            ready.clear();
+            for (size_t i = 2; i < pfds.size(); i++)
+                (pfds[i].revents ? ready : idle).push_back(pfds[i].fd);
+            if (pfds[0].revents & POLLIN) {
+                int cfd = accept(lfd, nullptr, nullptr);
+                if (cfd >= 0) {
+                    setsockopt(cfd, SOL_SOCKET, SO_RCVTIMEO, &readTimeout, sizeof readTimeout);
+                    connections.fetch_add(1);
+                    idle.push_back(cfd);
+                }
+            }
+            if (ready.empty()) continue;
+            lock_guard<mutex> lock(mu);
+            pending.insert(pending.end(), ready.begin(), ready.end());
+            cv.notify_all();
+        }
+
+        {
+            lock_guard<mutex> lock(mu);
+            stopping = true;
+            for (int fd : pending) close(fd);
+            pending.clear();
+        }
+        cv.notify_all();
+        for (auto &th : pool) th.join();
+        for (int fd : idle) close(fd);
+        for (int fd : returned) close(fd);
+        close(wakePipe[0]);
+        close(wakePipe[1]);
+        close(lfd);
+        unlink(socketPath.c_str());
+
+        QueryStats s = snapshot();
+        cout << "served " << s.queries << " queries in " << s.batches << " batches over "
+             << s.connections << " connections; p50 " << s.p50Ns << " ns, p99 " << s.p99Ns
+             << " ns, p999 " << s.p999Ns << " ns\n";
+        return 0;
+    }
+};
+
+int runServeCommand(int argc, char **argv) {
+    if (argc < 4) {
+        cerr << "usage: " << argv[0] << " --serve SOCKET (FILE | W H SEED) [THREADS]\n";
+        return 2;
+    }
+    MazeView view;
+    int next = 4;
+    if (!isMazeFileArg(argv[3])) {
+        int W = atoi(argv[3]), H = argc > 4 ? atoi(argv[4]) : 0;
+        unsigned seed = argc > 5 ? (unsigned)strtoul(argv[5], nullptr, 10) : (unsigned)time(NULL);
+        if (W < 1 || H < 1) {
+            cerr << "W and H must be positive\n";
+            return 2;
+        }
+        Maze mz(W, H);
+        generateMaze(mz, seed);
+        view.fromMaze(mz);
+        next = 6;
+    } else {
+        string err;
+        if (!view.load(argv[3], err)) {
+            cerr << err << "\n";
+            return 1;
+        }
+    }
+    int threads = argc > next ? atoi(argv[next]) : (int)thread::hardware_concurrency();
+    QueryServer server(view, max(1, threads));
+    return server.run(argv[2]);
+}
+
+/* ---------- Query client ---------- */
+static int connectQuerySocket(const string &socketPath) {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof addr.sun_path) return -1;
+    strcpy(addr.sun_path, socketPath.c_str());
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (sockaddr *)&addr, sizeof addr) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool sendQuery(int fd, uint16_t op, const vector<QueryPair> &pairs,
+                      ReplyHeader &rh, vector<uint32_t> &payload) {
+    QueryHeader q = { QUERY_MAGIC, op, 0, (uint32_t)pairs.size() };
+    if (!writeFull(fd, &q, sizeof q)) return false;
+    if (!pairs.empty() && !writeFull(fd, pairs.data(), pairs.size() * sizeof(QueryPair))) return false;
+    if (!readFull(fd, &rh, sizeof rh) || rh.magic != QUERY_MAGIC) return false;
+    payload.resize(rh.payloadWords);
+    return payload.empty() || readFull(fd, payload.data(), payload.size() * sizeof(uint32_t));
+}
+
+// Protocol checks against a running server: out-of-range pairs answer -1
+// (or an empty path), and a STATS request carrying pairs is rejected with
+// count 0 and its connection closed, while the server keeps serving.
+static int checkQueryServer(const string &socketPath) {
+    int failures = 0;
+    auto expect = [&](bool ok, const char *what) {
+        cout << (ok ? "ok    " : "FAIL  ") << what << "\n";
+        if (!ok) failures++;
+    };
+    int fd = connectQuerySocket(socketPath);
+    ReplyHeader rh;
+    vector<uint32_t> payload;
+    vector<QueryPair> pairs;
+    bool got = fd >= 0 && sendQuery(fd, OP_STATS, pairs, rh, payload) && rh.status == QUERY_OK;
+    expect(got, "stats");
+    if (!got) {
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+    uint32_t W = rh.width, H = rh.height, far = UINT32_MAX;
+    pairs = { { W, 0, 0, 0 }, { 0, H, 0, 0 }, { 0, 0, W, 0 }, { 0, 0, 0, H },
+              { far, far, far, far }, { 0, 0, far, far }, { far / W, far / W, far / W, far / W } };
+    bool wide = needsWideIndex((int)W, (int)H);
+    for (uint16_t op : { OP_DISTANCE, OP_PATH }) {
+        got = sendQuery(fd, op, pairs, rh, payload) && rh.status == QUERY_OK && rh.count == pairs.size();
+        size_t words = pairs.size() * (wide ? 2 : 1);
+        bool allMissing = got && payload.size() == words;
+        for (size_t i = 0; allMissing && i < words; i++)
+            allMissing = payload[i] == (op == OP_DISTANCE ? UINT32_MAX : 0);
+        expect(allMissing, op == OP_DISTANCE ? "out-of-range pairs: distance -1" : "out-of-range pairs: empty path");
+    }
+    close(fd);
+
+    // Header and pairs go out in one write, so the server's early close
+    // cannot cut the request short.
+    fd = connectQuerySocket(socketPath);
+    QueryHeader q = { QUERY_MAGIC, OP_STATS, 0, 2 };
+    vector<char> request(sizeof q + 2 * sizeof(QueryPair), 0);
+    memcpy(request.data(), &q, sizeof q);
+    char extra;
+    got = fd >= 0 && writeFull(fd, request.data(), request.size()) && readFull(fd, &rh, sizeof rh);
+    expect(got && rh.status == QUERY_BAD_REQUEST && rh.count == 0 && rh.payloadWords == 0,
+           "stats with pairs: rejected, count 0");
+    expect(got && !readFull(fd, &extra, 1), "stats with pairs: connection closed");
+    if (fd >= 0) close(fd);
+
+    fd = connectQuerySocket(socketPath);
+    pairs = { { 0, 0, W - 1, H - 1 } };
+    expect(fd >= 0 && sendQuery(fd, OP_DISTANCE, pairs, rh, payload) && rh.status == QUERY_OK,
+           "server still answers");
+    if (fd >= 0) close(fd);
+    return failures ? 1 : 0;
+}
+
+int runQueryCommand(int argc, char **argv) {
+    string what = argc > 3 ? argv[3] : "";
+    if (what != "dist" && what != "path" && what != "stats" && what != "bench" && what != "check") {
+        cerr << "usage: " << argv[0] << " --query SOCKET (dist | path) X1 Y1 X2 Y2 [...]\n"
+             << "       " << argv[0] << " --query SOCKET stats\n"
+             << "       " << argv[0] << " --query SOCKET bench COUNT [BATCH]\n"
+             << "       " << argv[0] << " --query SOCKET check\n";
+        return 2;
+    }
+    if (what == "check") return checkQueryServer(argv[2]);
+    int fd = connectQuerySocket(argv[2]);
+    if (fd < 0) {
+        cerr << "cannot connect to " << argv[2] << "\n";
+        return 1;
+    }
+
+    ReplyHeader rh;
+    vector<uint32_t> payload;
+    vector<QueryPair> pairs;
+    int rc = 0;
+    if (what == "stats") {
+        if (!sendQuery(fd, OP_STATS, pairs, rh, payload) || rh.status != QUERY_OK) rc = 1;
+        else {
+            QueryStats s;
+            memcpy(&s, payload.data(), sizeof s);
+            double secs = max(s.uptimeUs, (uint64_t)1) / 1e6;
+            cout << "maze " << rh.width << "x" << rh.height << ", up " << secs << " s\n"
+                 << s.queries << " queries, " << s.batches << " batches, "
+                 << s.connections << " connections, " << (uint64_t)(s.queries / secs) << " queries/s\n"
+                 << "latency p50 " << s.p50Ns << " ns, p99 " << s.p99Ns << " ns, p999 "
+                 << s.p999Ns << " ns, max " << s.maxNs << " ns\n";
+        }
+    } else if (what == "bench") {
+        long long count = argc > 4 ? atoll(argv[4]) : 10000;
+        int batch = argc > 5 ? max(1, min(atoi(argv[5]), (int)QUERY_MAX_BATCH)) : 64;
+        if (!sendQuery(fd, OP_STATS, pairs, rh, payload)) rc = 1;
+        mt19937 rng(12345);
+        auto t0 = chrono::steady_clock::now();
+        for (long long done = 0; rc == 0 && done < count; done += (long long)pairs.size()) {
+            pairs.resize((size_t)min<long long>(batch, count - done));
+            for (QueryPair &p : pairs)
+                p = { (uint32_t)(rng() % rh.width), (uint32_t)(rng() % rh.height),
+                      (uint32_t)(rng() % rh.width), (uint32_t)(rng() % rh.height) };
+            if (!sendQuery(fd, OP_DISTANCE, pairs, rh, payload) || rh.status != QUERY_OK) rc = 1;
+        }
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+        if (rc == 0)
+            cout << count << " distance queries in batches of " << batch << ": "
+                 << secs * 1000 << " ms, " << (long long)(count / max(secs, 1e-9)) << " queries/s\n";
+    } else {
+        for (int i = 4; i + 3 < argc; i += 4)
+            pairs.push_back({ (uint32_t)atoi(argv[i]), (uint32_t)atoi(argv[i+1]),
+                              (uint32_t)atoi(argv[i+2]), (uint32_t)atoi(argv[i+3]) });
+        if (pairs.empty() || !sendQuery(fd, what == "dist" ? OP_DISTANCE : OP_PATH, pairs, rh, payload) ||
+            rh.status != QUERY_OK) {
+            rc = 1;
+        } else {
+            bool wide = needsWideIndex((int)rh.width, (int)rh.height);
+            size_t at = 0;
+            auto next = [&]() -> int64_t {
+                if (!wide) return (int32_t)payload[at++];
+                uint64_t lo = payload[at++];
+                return (int64_t)(lo | (uint64_t)payload[at++] << 32);
+            };
+            for (const QueryPair &p : pairs) {
+                cout << "(" << p.fromX << "," << p.fromY << ") -> (" << p.toX << "," << p.toY << "): ";
+                if (what == "dist") {
+                    cout << next() << "\n";
+                    continue;
+                }
+                int64_t n = next();
+                if (n == 0) cout << "unreachable";
+                for (int64_t k = 0; k < n; k++) {
+                    Point c = cellPoint(next(), (int)rh.width);
+                    cout << (k ? " " : "") << "(" << c.x << "," << c.y << ")";
+                }
+                cout << "\n";
+            }
+        }
+    }
+    if (rc != 0) cerr << "query failed\n";
+    close(fd);
+    return rc;
+}
+#endif
+
+#ifndef _WIN32
+/* ---------- Multi-process sharded solving over shared memory ---------- */
+// The parent writes the packed maze image into one POSIX shared-memory
+// object and the query list plus a control block into a second. The
+// parent unmaps its writable maze mapping and drops its source view before
+// forking, so each worker's only view of the walls is its own read-only
+// mapping; the work segment is the only thing a worker can write. Workers
+// claim batches of queries by a
+// fetch_add on the shared ticket counter, writing distances into its own
+// slots of the result array. No locks: the ticket is the only contended
+// word, and atomics on a MAP_SHARED page work across processes.
+struct ShardControl {
+    atomic<uint64_t> nextTicket;
+    uint64_t queryCount;
+    uint32_t batch, workers;
+};
+static_assert(atomic<uint64_t>::is_always_lock_free, "shared ticket needs a lock-free atomic");
+
+struct ShardQuery { int64_t from, to; };
+struct ShardWorkerStats { uint64_t queries, batches, ns; };
+
+struct ShardLayout {
+    size_t queriesAt, resultsAt, statsAt, bytes;
+    ShardLayout(uint64_t count, uint32_t workers) {
+        queriesAt = (sizeof(ShardControl) + 63) & ~size_t(63);
+        resultsAt = queriesAt + count * sizeof(ShardQuery);
+        statsAt = (resultsAt + count * sizeof(int64_t) + 63) & ~size_t(63);
+        bytes = statsAt + workers * sizeof(ShardWorkerStats);
+    }
+};
+
+// Maps a named shared-memory object; creates it (size `bytes`) when create is set.
+static void *mapShm(const string &name, size_t bytes, bool create, bool writable) {
+    int fd = shm_open(name.c_str(), create ? O_CREAT | O_EXCL | O_RDWR : (writable ? O_RDWR : O_RDONLY), 0600);
+    if (fd < 0) return nullptr;
+    if (create && ftruncate(fd, (off_t)bytes) != 0) { close(fd); return nullptr; }
+    void *p = mmap(nullptr, bytes, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+template<typename Index>
+static int shardWorker(const string &mazeName, size_t mazeBytes, const string &workName,
+                       size_t workBytes, uint32_t id) {
+    pinThreadToCpu((int)id);
+    const void *image = mapShm(mazeName, mazeBytes, false, false);
+    char *work = (char *)mapShm(workName, workBytes, false, true);
+    MazeView mz;
+    string err;
+    if (!image || !work || !mz.attach(image, mazeBytes, err)) return 1;
+
+    ShardControl &ctl = *(ShardControl *)work;
+    ShardLayout lay(ctl.queryCount, ctl.workers);
+    const ShardQuery *queries = (const ShardQuery *)(work + lay.queriesAt);
+    int64_t *results = (int64_t *)(work + lay.resultsAt);
+    ShardWorkerStats &st = ((ShardWorkerStats *)(work + lay.statsAt))[id];
+
+    BasicPathScratch<Index> scratch((Index)mz.mazeW * mz.mazeH);
+    auto t0 = chrono::steady_clock::now();
+    while (true) {
+        uint64_t first = ctl.nextTicket.fetch_add(ctl.batch, memory_order_relaxed);
+        if (first >= ctl.queryCount) break;
+        uint64_t last = min(first + ctl.batch, ctl.queryCount);
+        for (uint64_t q = first; q < last; q++)
+            results[q] = (int64_t)scratch.search(mz, (Index)queries[q].from, (Index)queries[q].to);
+        st.queries += last - first;
+        st.batches++;
+    }
+    st.ns = (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+    return 0;
+}
+
+int runShardCommand(int argc, char **argv) {
+    if (argc < 5) {
+        cerr << "usage: " << argv[0] << " --shard WORKERS QUERIES (FILE | W H [SEED]) [BATCH]\n";
+        return 2;
+    }
+    uint32_t workers = (uint32_t)max(1, atoi(argv[2]));
+    uint64_t count = (uint64_t)max(1LL, atoll(argv[3]));
+
+    unique_ptr<MazeView> source(new MazeView());
+    int next = 5;
+    if (!isMazeFileArg(argv[4])) {
+        int W = atoi(argv[4]), H = argc > 5 ? atoi(argv[5]) : 0;
+        unsigned seed = argc > 6 ? (unsigned)strtoul(argv[6], nullptr, 10) : (unsigned)time(NULL);
+        if (W < 1 || H < 1) {
+            cerr << "W and H must be positive\n";
+            return 2;
+        }
+        Maze mz(W, H);
+        generateMaze(mz, seed);
+        source->fromMaze(mz);
+        next = 7;
+    } else {
+        string err;
+        if (!source->load(argv[4], err)) {
+            cerr << err << "\n";
+            return 1;
+        }
+    }
+    uint32_t batch = argc > next ? (uint32_t)max(1, atoi(argv[next])) : 64;
+    int W = source->mazeW, H = source->mazeH;
+
+    string tag = to_string((long)getpid());
+    string mazeName = "/maze-walls-" + tag, workName = "/maze-work-" + tag;
+    size_t mazeBytes = mazeImageBytes(W, H);
+    ShardLayout lay(count, workers);
+    char *image = (char *)mapShm(mazeName, mazeBytes, true, true);
+    char *work = image ? (char *)mapShm(workName, lay.bytes, true, true) : nullptr;
+    auto cleanup = [&]() {
+        if (image) munmap(image, mazeBytes);
+        if (work) munmap(work, lay.bytes);
+        shm_unlink(mazeName.c_str());
+        shm_unlink(workName.c_str());
+    };
+    if (!image || !work) {
+        cerr << "cannot create shared memory: " << strerror(errno) << "\n";
+        cleanup();
+        return 1;
+    }
+
+    // The maze goes in once; workers only ever read it.
+    MazeFileHeader hdr;
+    memcpy(hdr.magic, MAZE_FILE_MAGIC, sizeof hdr.magic);
+    hdr.width = (uint32_t)W;
+    hdr.height = (uint32_t)H;
+    size_t planeBytes = (size_t)(H + 2) * source->stride * sizeof(uint64_t);
+    memcpy(image, &hdr, sizeof hdr);
+    memcpy(image + sizeof hdr, source->openRight, planeBytes);
+    memcpy(image + sizeof hdr + planeBytes, source->openDown, planeBytes);
+    // Nothing writable over the walls survives into the forked workers.
+    munmap(image, mazeBytes);
+    image = nullptr;
+    source.reset();
+
+    ShardControl *ctl = new (work) ShardControl();
+    ctl->nextTicket.store(0);
+    ctl->queryCount = count;
+    ctl->batch = batch;
+    ctl->workers = workers;
+    ShardQuery *queries = (ShardQuery *)(work + lay.queriesAt);
+    mt19937_64 rng(12345);
+    uint64_t cells = (uint64_t)W * H;
+    for (uint64_t q = 0; q < count; q++) queries[q] = { (int64_t)(rng() % cells), (int64_t)(rng() % cells) };
+    memset(work + lay.statsAt, 0, workers * sizeof(ShardWorkerStats));
+
+    bool wide = needsWideIndex(W, H);
+    auto t0 = chrono::steady_clock::now();
+    vector<pid_t> children;
+    cout << flush;
+    for (uint32_t id = 0; id < workers; id++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            int rc = wide ? shardWorker<int64_t>(mazeName, mazeBytes, workName, lay.bytes, id)
+                          : shardWorker<int>(mazeName, mazeBytes, workName, lay.bytes, id);
+            _exit(rc);
+        }
+        if (pid > 0) children.push_back(pid);
+    }
+    int failed = 0;
+    for (pid_t pid : children) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed++;
+    }
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    const int64_t *results = (const int64_t *)(work + lay.resultsAt);
+    const ShardWorkerStats *stats = (const ShardWorkerStats *)(work + lay.statsAt);
+    int64_t sum = 0;
+    uint64_t answered = 0;
+    for (uint64_t q = 0; q < count; q++) sum += results[q];
+    for (uint32_t id = 0; id < workers; id++) answered += stats[id].queries;
+    cout << "sharded " << count << " queries on a " << W << "x" << H << " maze over "
+         << children.size() << " processes: " << secs * 1000 << " ms, "
+         << (long long)(count / max(secs, 1e-9)) << " queries/s, distance sum " << sum << "\n";
+    for (uint32_t id = 0; id < workers; id++)
+        cout << "  worker " << id << ": " << stats[id].queries << " queries in "
+             << stats[id].batches << " batches, " << stats[id].ns / 1000000.0 << " ms\n";
+    cleanup();
+    if (failed || answered != count || children.size() != workers) {
+        cerr << "workers failed: " << failed << " exited with errors, " << answered << " of "
+             << count << " queries answered\n";
+        return 1;
+    }
+    return 0;
+}
+#endif
+
+#ifndef _WIN32
+/* ---------- Persistent result cache ---------- */
+// Two append-only files in a cache directory: index.bin holds fixed-size
+// entries and data.bin the paths they point at. The index is memory-mapped
+// and searched newest-first, so a lookup costs no parsing and later
+// entries win. Appends take an flock and write the path before the entry;
+// a torn entry fails its check word and is skipped, so a crash never
+// yields a result without its path. Besides results (keyed by maze hash,
+// algorithm, start and goal), seed entries map (W, H, seed) to the maze
+// hash so a cached run does not have to regenerate the maze.
+struct CachedResult {
+    uint64_t mazeHash, start, goal;
+    uint64_t dataOffset, cells, expansions, solveNs;
+};
+struct SeedAlias {
+    uint32_t width, height, seed;
+    uint32_t braidPpm;      // MAZE_BRAID in parts per million, 0 when perfect
+    uint64_t mazeHash;      // hash of the maze that seed generates
+};
+struct CacheEntry {
+    uint32_t magic;
+    uint16_t kind, algo;
+    union {                 // by kind
+        CachedResult result;
+        SeedAlias alias;
+    };
+    uint64_t check;
+};
+static_assert(sizeof(CacheEntry) == 72, "cache entries are fixed-size records");
+static_assert(sizeof(SeedAlias) <= sizeof(CachedResult), "CachedResult spans the payload");
+
+class ResultCache {
+public:
+    static const uint32_t MAGIC = 0x4843414D;   // "MACH"
+    enum Kind : uint16_t { RESULT = 1, SEED = 2 };
+
+    ~ResultCache() {
+        if (mapped) munmap(mapped, mappedLen);
+        if (indexFd >= 0) close(indexFd);
+        if (dataFd >= 0) close(dataFd);
+    }
+
+    bool open(const string &dir, string &err) {
+        mkdir(dir.c_str(), 0755);
+        indexFd = ::open((dir + "/index.bin").c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+        dataFd = ::open((dir + "/data.bin").c_str(), O_RDWR | O_CREAT, 0644);
+        if (indexFd < 0 || dataFd < 0) {
+            err = "cannot open cache in " + dir + ": " + strerror(errno);
+            return false;
+        }
+        return true;
+    }
+
+    bool findResult(uint16_t algo, uint64_t hash, uint64_t start, uint64_t goal, CachedResult &out) {
+        const CacheEntry *e = find(RESULT, [&](const CacheEntry &c) {
+            return c.algo == algo && c.result.mazeHash == hash && c.result.start == start && c.result.goal == goal;
+        });
+        if (e) out = e->result;
+        return e != nullptr;
+    }
+
+    bool findSeed(const SeedAlias &key, SeedAlias &out) {
+        const CacheEntry *e = find(SEED, [&](const CacheEntry &c) {
+            return c.alias.width == key.width && c.alias.height == key.height &&
+                   c.alias.seed == key.seed && c.alias.braidPpm == key.braidPpm;
+        });
+        if (e) out = e->alias;
+        return e != nullptr;
+    }
+
+    bool readPath(const CachedResult &r, vector<int64_t> &path) {
+        path.resize(r.cells);
+        size_t bytes = path.size() * sizeof(int64_t);
+        return bytes == 0 || pread(dataFd, path.data(), bytes, (off_t)r.dataOffset) == (ssize_t)bytes;
+    }
+
+    bool appendResult(uint16_t algo, CachedResult r, const vector<int64_t> &path) {
+        CacheEntry e = {};
+        e.kind = RESULT;
+        e.algo = algo;
+        e.result = r;
+        return append(e, &path);
+    }
+
+    bool appendSeed(const SeedAlias &a) {
+        CacheEntry e = {};
+        e.kind = SEED;
+        e.alias = a;
+        return append(e, nullptr);
+    }
+
+private:
+    int indexFd = -1, dataFd = -1;
+    void *mapped = nullptr;
+    size_t mappedLen = 0;
+
+    // Newest intact entry of this kind that `match` accepts, or null.
+    template<typename Match>
+    const CacheEntry *find(Kind kind, Match match) {
+        remap();
+        const CacheEntry *entries = (const CacheEntry *)mapped;
+        for (size_t i = mappedLen / sizeof(CacheEntry); i-- > 0; ) {
+            const CacheEntry &e = entries[i];
+            if (e.magic == MAGIC && e.kind == kind && match(e) && e.check == checkOf(e)) return &e;
+        }
+        return nullptr;
+    }
+
+    // Results write their path to data.bin first (null for seed entries).
+    bool append(CacheEntry e, const vector<int64_t> *path) {
+        if (flock(indexFd, LOCK_EX) != 0) return false;
+        bool ok = true;
+        if (path) {
+            off_t at = lseek(dataFd, 0, SEEK_END);
+            size_t bytes = path->size() * sizeof(int64_t);
+            ok = at >= 0 && (bytes == 0 || pwrite(dataFd, path->data(), bytes, at) == (ssize_t)bytes);
+            e.result.dataOffset = (uint64_t)at;
+            e.result.cells = path->size();
+        }
+        if (ok) {
+            e.magic = MAGIC;
+            e.check = checkOf(e);
+            ok = write(indexFd, &e, sizeof e) == (ssize_t)sizeof e;
+        }
+        flock(indexFd, LOCK_UN);
+        return ok;
+    }
+
+    static uint64_t checkOf(const CacheEntry &e) {
+        // Hash the payload bytes, whichever member is active.
+        uint64_t words[sizeof(CachedResult) / sizeof(uint64_t)];
+        memcpy(words, &e.result, sizeof words);
+        MazeHasher hs(e.kind, e.algo);
+        for (uint64_t v : words) hs.update(v);
+        return hs.digest();
+    }
+
+    // Maps whole entries only; a partly written tail entry is left out.
+    void remap() {
+        struct stat st;
+        if (fstat(indexFd, &st) != 0) return;
+        size_t len = (size_t)st.st_size / sizeof(CacheEntry) * sizeof(CacheEntry);
+        if (len == mappedLen) return;
+        if (mapped) munmap(mapped, mappedLen);
+        mapped = nullptr;
+        mappedLen = 0;
+        if (len == 0) return;
+        void *p = mmap(nullptr, len, PROT_READ, MAP_SHARED, indexFd, 0);
+        if (p == MAP_FAILED) return;
+        mapped = p;
+        mappedLen = len;
+    }
+};
+#endif
+
+/* ---------- Checkpointed BFS / Dijkstra / A* ---------- */
+// The skipBFS/skipPQ searches (algo 1-3) with g and parent kept in a
+// CheckpointFile; g is stored as g + 1 so a fresh file reads as all
+// unseen and stays sparse. A commit records F, the lowest f still open.
+// With these consistent heuristics every cell whose stored g + h is below
+// F was closed and final by then, and anything written after the commit
+// has g + h >= F, so a resume keeps the former, clears the rest and
+// reopens the cells bordering the kept set. `expanded` carries over.
+bool solveCheckpointed(const Maze &mz, int algo, uint64_t mazeKey, vector<int> &parentOf,
+                       uint64_t &expanded, bool &found, const string &checkpoint, string &err) {
+    int W = mz.mazeW, H = mz.mazeH, N = W * H, goal = cellId(W-1, H-1, W);
+    CheckpointFile ckp;
+    uint32_t kind = CheckpointFile::SOLVE_BFS + (algo - 1);
+    if (!ckp.open(checkpoint, kind, W, H, mazeKey, 2 * (size_t)N * sizeof(int32_t), err)) return false;
+    int32_t *g1 = (int32_t *)ckp.data(), *par = g1 + N;
+
+    auto h = [&](int v) {
+        if (algo != 3) return 0;
+        Point p = cellPt(v, W);
+        return (W - 1 - p.x) + (H - 1 - p.y);
+    };
+    auto neighbours = [&](int u, auto visit) {
+        Point pu = cellPt(u, W);
+        for (int dir = 0; dir < 4; dir++) {
+            if (mz.canMove(pu.x, pu.y, dir))
+                visit(cellId(pu.x + (dir==1) - (dir==3), pu.y + (dir==2) - (dir==0), W));
+        }
+    };
+    queue<int> fifo;
+    using P = pair<int,int>;
+    priority_queue<P, vector<P>, greater<P>> pq;
+    auto open = [&](int v) {
+        if (algo == 1) fifo.push(v);
+        else pq.push({ g1[v] - 1 + h(v), v });
+    };
+    // Next cell to expand (stale heap entries dropped), or -1.
+    auto peek = [&]() {
+        if (algo == 1) return fifo.empty() ? -1 : fifo.front();
+        while (!pq.empty() && pq.top().first != g1[pq.top().second] - 1 + h(pq.top().second)) pq.pop();
+        return pq.empty() ? -1 : pq.top().second;
+    };
+
+    expanded = ckp.counter();
+    if (ckp.resumed()) {
+        int64_t F = (int64_t)ckp.cursor();
+        auto kept = [&](int v) { return g1[v] > 0 && g1[v] - 1 + h(v) < F; };
+        for (int v = 0; v < N; v++) {
+            if (!kept(v)) g1[v] = 0;
+        }
+        for (int v = 0; v < N; v++) {
+            if (!kept(v)) continue;
+            neighbours(v, [&](int w) {
+                if (kept(w) || (g1[w] != 0 && g1[w] <= g1[v] + 1)) return;
+                bool fresh = g1[w] == 0;
+                g1[w] = g1[v] + 1;
+                par[w] = v;
+                if (algo != 1 || fresh) open(w);
+            });
+        }
+    } else {
+        g1[0] = 1;
+        par[0] = -1;
+        open(0);
+    }
+
+    found = false;
+    for (uint64_t step = 1; ; step++) {
+        int u = peek();
+        if (u < 0) break;
+        if (algo == 1) fifo.pop(); else pq.pop();
+        expanded++;
+        if (u == goal) { found = true; break; }
+        neighbours(u, [&](int v) {
+            if (g1[v] != 0 && g1[v] <= g1[u] + 1) return;
+            g1[v] = g1[u] + 1;
+            par[v] = u;
+            open(v);
+        });
+        if ((step & 0xFFFF) == 0 && ckp.due()) {
+            int next = peek();
+            if (next >= 0) ckp.commit((uint64_t)(g1[next] - 1 + h(next)), expanded);
+        }
+    }
+    for (int v = 0; v < N; v++) parentOf[v] = g1[v] ? par[v] : -1;
+    ckp.remove();
+    return true;
+}
+
+/* ---------- Command line: solve one maze (optionally cached) ---------- */
+// With MAZE_CHECKPOINT=PATH set, generation commits to PATH.gen and BFS,
+// Dijkstra and A* to PATH.solve; a rerun of the same job resumes from
+// them. DFS always runs from scratch.
+int runSolveCommand(int argc, char **argv) {
+    const char *algoNames[] = { "dfs", "bfs", "dijkstra", "astar" };
+    int algo = -1;
+    for (int a = 0; argc > 2 && a < 4; a++) if (strcmp(argv[2], algoNames[a]) == 0) algo = a;
+    if (argc < 4 || algo < 0) {
+        cerr << "usage: " << argv[0] << " --solve (dfs | bfs | dijkstra | astar) (FILE | W H SEED) [CACHE_DIR]\n";
+        return 2;
+    }
+
+    bool fromSeed = !isMazeFileArg(argv[3]);
+    int W = 0, H = 0;
+    unsigned seed = 0;
+    int next = 4;
+    if (fromSeed) {
+        if (argc < 6) {
+            cerr << "W H SEED expected\n";
+            return 2;
+        }
+        W = atoi(argv[3]);
+        H = atoi(argv[4]);
+        seed = (unsigned)strtoul(argv[5], nullptr, 10);
+        next = 6;
+        if (W < 1 || H < 1 || needsWideIndex(W, H)) {
+            cerr << "W and H must be positive and W * H below 2^31\n";
+            return 2;
+        }
+    }
+    string cacheDir = argc > next ? argv[next] : "";
+
+    auto report = [&](int64_t cells, uint64_t expanded, uint64_t ns, uint64_t hash, const char *how) {
+        char buf[256];
+        snprintf(buf, sizeof buf, "%s %dx%d: path %lld moves, %llu expanded, %.3f ms (%s), maze %016llx\n",
+                 algoNames[algo], W, H, (long long)(cells > 0 ? cells - 1 : -1),
+                 (unsigned long long)expanded, ns / 1e6, how, (unsigned long long)hash);
+        cout << buf;
+    };
+
+#ifndef _WIN32
+    ResultCache cache;
+    bool cached = false;
+    if (!cacheDir.empty()) {
+        string err;
+        if (!cache.open(cacheDir, err)) {
+            cerr << err << "\n";
+            return 1;
+        }
+        cached = true;
+    }
+    // A hit only counts if its stored path really runs start to goal. The
+    // time reported is the lookup's; the original solve time is shown
+    // alongside it as history.
+    auto lookupStart = chrono::steady_clock::now();
+    auto cachedResult = [&](uint64_t hash, int64_t goal) {
+        CachedResult res;
+        vector<int64_t> path;
+        if (!cache.findResult((uint16_t)algo, hash, 0, (uint64_t)goal, res) ||
+            !cache.readPath(res, path) || (!path.empty() && (path.front() != 0 || path.back() != goal)))
+            return false;
+        uint64_t ns = (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - lookupStart).count();
+        char how[64];
+        snprintf(how, sizeof how, "cache lookup; first solve took %.3f ms", res.solveNs / 1e6);
+        report((int64_t)path.size(), res.expansions, ns, hash, how);
+        return true;
+    };
+    SeedAlias seedKey = {}, alias;
+    seedKey.width = (uint32_t)W;
+    seedKey.height = (uint32_t)H;
+    seedKey.seed = seed;
+    seedKey.braidPpm = braidPpm();
+    bool haveAlias = cached && fromSeed && cache.findSeed(seedKey, alias);
+    if (haveAlias && cachedResult(alias.mazeHash, (int64_t)W * H - 1)) return 0;
+#else
+    if (!cacheDir.empty()) cerr << "result cache not supported on this platform\n";
+#endif
+
+    const char *checkpoint = getenv("MAZE_CHECKPOINT");
+    unique_ptr<Maze> mz;
+    if (fromSeed) {
+        mz.reset(new Maze(W, H));
+        string err;
+        if (!checkpoint) mz->generateRandom(seed);
+        else if (!mz->generateRandom(seed, string(checkpoint) + ".gen", err)) {
+            cerr << err << "\n";
+            return 1;
+        }
+        braidIfAsked(*mz, seed);
+    } else {
+        MazeView view;
+        string err;
+        if (!view.load(argv[3], err)) {
+            cerr << err << "\n";
+            return 1;
+        }
+        if (needsWideIndex(view.mazeW, view.mazeH)) {
+            cerr << "maze too large for --solve\n";
+            return 2;
+        }
+        mz.reset(new Maze(mazeFromView(view)));
+        W = mz->mazeW;
+        H = mz->mazeH;
+    }
+    uint64_t hash = mazeHash(*mz);
+    int goal = W * H - 1;
+
+#ifndef _WIN32
+    if (cached && fromSeed && !haveAlias) {
+        seedKey.mazeHash = hash;
+        cache.appendSeed(seedKey);
+    }
+    lookupStart = chrono::steady_clock::now();
+    if (cached && cachedResult(hash, goal)) return 0;
+#endif
+
+    vector<int> cells;
+    uint64_t expanded = 0;
+    auto t0 = chrono::steady_clock::now();
+    if (checkpoint && algo != 0) {
+        vector<int> parentOf(W * H, -1);
+        bool found = false;
+        string err;
+        if (!solveCheckpointed(*mz, algo, hash, parentOf, expanded, found,
+                               string(checkpoint) + ".solve", err)) {
+            cerr << err << "\n";
+            return 1;
+        }
+        if (found) cells = pathCellsFrom(parentOf, goal);
+    } else {
+        cells = skipClassic(*mz, algo, NoObserver(), [&](int){ expanded++; }).cells;
+    }
+    uint64_t ns = (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+    vector<int64_t> path(cells.rbegin(), cells.rend());
+    report((int64_t)path.size(), expanded, ns, hash, "solved");
+
+#ifndef _WIN32
+    if (cached) {
+        CachedResult r = {};
+        r.mazeHash = hash;
+        r.goal = (uint64_t)goal;
+        r.expansions = expanded;
+        r.solveNs = ns;
+        if (!cache.appendResult((uint16_t)algo, r, path)) cerr << "cannot write cache entry\n";
+    }
+#endif
+    return 0;
+}
+
+/* ---------- Background maze pool ---------- */
+// A producer thread keeps a few mazes of the current size generated ahead,
+// each with its AsciiCanvas base frame, so "Generate a NEW maze" is
+// instant. The pool holds as many as fit in MAZE_POOL_MB (default 64 MB),
+// at most MAX_READY; when one maze alone exceeds the budget nothing is
+// kept and take() generates on the spot.
+struct ReadyMaze {
+    unique_ptr<Maze> maze;
+    unique_ptr<AsciiCanvas> canvas;
+};
+
+class MazePool {
+public:
+    static constexpr size_t MAX_READY = 4;
+
+    MazePool(int w, int h) : W(w), H(h), rng(random_device{}()) {
+        const char *env = getenv("MAZE_POOL_MB");
+        size_t budget = (size_t)(env ? max(0, atoi(env)) : 64) << 20;
+        capacity = min(MAX_READY, budget / bytesPerMaze());
+        if (capacity > 0) producer = thread(&MazePool::produce, this);
+    }
+    ~MazePool() {
+        {
+            lock_guard<mutex> lock(mu);
+            stopping = true;
+        }
+        cv.notify_all();
+        if (producer.joinable()) producer.join();
+    }
+
+    ReadyMaze take() {
+        unsigned seed;
+        {
+            lock_guard<mutex> lock(mu);
+            if (!ready.empty()) {
+                ReadyMaze m = move(ready.front());
+                ready.pop_front();
+                cv.notify_all();
+                return m;
+            }
+            seed = rng();
+        }
+        return build(seed);
+    }
+
+private:
+    int W, H;
+    size_t capacity = 0;
+    mt19937 rng;     // seeds; generateRandom() would repeat within a second
+    mutex mu;
+    condition_variable cv;
+    deque<ReadyMaze> ready;
+    bool stopping = false;
+    thread producer;
+
+    // Wall bits, per-column vector headers and the canvas base grid.
+    size_t bytesPerMaze() const {
+        return (size_t)W * H / 4 + (size_t)W * 2 * sizeof(vector<bool>) +
+               (size_t)(2 * H + 1) * (2 * W + 1 + sizeof(string)) + 256;
+    }
+
+    ReadyMaze build(unsigned seed) {
+        ReadyMaze m;
+        m.maze.reset(new Maze(W, H));
+        generateMaze(*m.maze, seed);
+        m.canvas.reset(new AsciiCanvas(*m.maze));
+        return m;
+    }
+
+    void produce() {
+        unique_lock<mutex> lock(mu);
+        while (true) {
+            cv.wait(lock, [&] { return stopping || ready.size() < capacity; });
+            if (stopping) return;
+            unsigned seed = rng();
+            lock.unlock();
+            ReadyMaze m = build(seed);
+            lock.lock();
+            ready.push_back(move(m));
+        }
+    }
+};
+
+/* ---------- Speculative skipped runs ---------- */
+// While the user sits in the legend and prompts, worker threads run every
+// solver that has a skip mode on the current maze and keep its outcome,
+// so a skipped run draws at once. Nothing runs until start(), which main
+// calls only once the user has shown they skip animations; pause() lets
+// the in-flight runs finish and stops claiming more, so the self-timing
+// modes (anytime A*, HDA*, race) measure an idle machine. Asking for a
+// run nobody has started yet runs it on the caller instead of waiting
+// behind the others.
+class Speculation {
+public:
+    explicit Speculation(const Maze &m) : mz(m) {
+        for (const char *k = KEYS; *k; k++) tasks.emplace_back(new Task(*k));
+    }
+    ~Speculation() { pause(); }
+    Speculation(const Speculation &) = delete;
+    Speculation &operator=(const Speculation &) = delete;
+
+    void start() {
+        if (!pool.empty()) return;
+        stopping = false;
+        int workers = max(1, min((int)thread::hardware_concurrency(), (int)tasks.size()));
+        for (int i = 0; i < workers; i++) pool.emplace_back(&Speculation::work, this);
+    }
+    void pause() {
+        stopping = true;
+        for (auto &t : pool) t.join();
+        pool.clear();
+    }
+
+    // Built once per maze and shared by the speculative and live ALT runs.
+    const Landmarks &landmarks() {
+        call_once(landmarksOnce, [&] { lm.reset(new Landmarks(mz, 8)); });
+        return *lm;
+    }
+
+    static bool covers(char choice) {
+        return strchr(KEYS, tolower((unsigned char)choice)) != nullptr;
+    }
+
+    const SolveOutcome &get(char choice) {
+        Task &t = *tasks[strchr(KEYS, tolower((unsigned char)choice)) - KEYS];
+        int pending = PENDING;
+        if (t.state.compare_exchange_strong(pending, RUNNING)) run(t);
+        unique_lock<mutex> lock(mu);
+        cv.wait(lock, [&] { return t.state.load() == DONE; });
+        return t.out;
+    }
+
+private:
+    static constexpr const char *KEYS = "123456789b";
+    enum { PENDING, RUNNING, DONE };
+    struct Task {
+        char key;
+        atomic<int> state{ PENDING };
+        SolveOutcome out;
+        explicit Task(char k) : key(k) {}
+    };
+
+    const Maze &mz;
+    vector<unique_ptr<Task>> tasks;
+    vector<thread> pool;
+    atomic<bool> stopping{ false };
+    mutex mu;
+    condition_variable cv;
+    once_flag landmarksOnce;
+    unique_ptr<Landmarks> lm;
+
+    void work() {
+        for (auto &t : tasks) {
+            if (stopping) return;
+            int pending = PENDING;
+            if (t->state.compare_exchange_strong(pending, RUNNING)) run(*t);
+        }
+    }
+
+    void run(Task &t) {
+        int W = mz.mazeW, H = mz.mazeH, goal = cellId(W-1, H-1, W);
+        auto manH = [&](int v) {
+            Point p = cellPt(v, W);
+            return abs(p.x - (W - 1)) + abs(p.y - (H - 1));
+        };
+        switch (t.key) {
+            case '1': t.out = skipDFS(mz); break;
+            case '2': t.out = skipBFS(mz); break;
+            case '3': t.out = skipPQ(mz, [](int){ return 0; }, "Dijkstra"); break;
+            case '4': t.out = skipPQ(mz, manH, "A*"); break;
+            case '5': t.out = skipLowMemory(mz, false); break;
+            case '6': t.out = skipLowMemory(mz, true); break;
+            case '7': t.out = skipBitBFS(mz); break;
+            case '8': t.out = skipDeadEndFill(mz, 1); break;
+            case '9': t.out = skipPQ(mz, AltHeuristic{ &landmarks(), goal }, "A* (ALT)"); break;
+            case 'b': t.out = skipBidirectional(mz); break;
+        }
+        {
+            lock_guard<mutex> lock(mu);
+            t.state = DONE;
+        }
+        cv.notify_all();
+    }
+};
+
+/* ---------- Constrained generation ---------- */
+// Targets a generated maze must meet. River is the share of cells that
+// are plain corridor (exactly two openings): high for long winding
+// passages, low for mazes full of short side branches.
+struct MazeTargets {
+    int pathMin = 0, pathMax = INT_MAX;
+    int minDeadEnds = 0;
+    double minRiver = 0;
+};
+
+struct MazeScore {
+    int pathLen = -1, deadEnds = 0, corridors = 0;
+    enum Verdict { ACCEPT, PATH, DEAD_ENDS, RIVER } verdict = ACCEPT;
+};
+
+// One BFS from the start that also counts each cell's openings as it is
+// visited. Rejects as soon as a target is out of reach: the goal turns
+// up too near, the wavefront passes pathMax without it, or the cells not
+// yet visited could no longer make up the dead ends or corridors. Stops
+// at the goal when no count target is set. dist and que are scratch.
+bool scoreMaze(const Maze &mz, const MazeTargets &t, MazeScore &s,
+               vector<int> &dist, vector<int> &que) {
+    int W = mz.mazeW, H = mz.mazeH, N = W * H, goal = cellId(W-1, H-1, W);
+    long long minCorridors = (long long)ceil(t.minRiver * N);
+    bool needCounts = t.minDeadEnds > 0 || minCorridors > 0;
+    s = MazeScore();
+    dist.assign(N, -1);
+    que.clear();
+    dist[0] = 0;
+    que.push_back(0);
+    for (size_t head = 0; head < que.size(); head++) {
+        int u = que[head];
+        if (s.pathLen < 0 && dist[u] > t.pathMax) { s.verdict = MazeScore::PATH; return false; }
+        if (u == goal) {
+            s.pathLen = dist[u];
+            if (s.pathLen < t.pathMin) { s.verdict = MazeScore::PATH; return false; }
+            if (!needCounts) return true;
+        }
+        Point pu = cellPt(u, W);
+        int degree = 0;
+        for (int dir = 0; dir < 4; dir++) {
+            if (!mz.canMove(pu.x, pu.y, dir)) continue;
+            degree++;
+            int v = cellId(pu.x + (dir==1) - (dir==3), pu.y + (dir==2) - (dir==0), W);
+            if (dist[v] < 0) { dist[v] = dist[u] + 1; que.push_back(v); }
+        }
+        s.deadEnds += degree == 1;
+        s.corridors += degree == 2;
+        long long unseen = N - (long long)head - 1;
+        if (s.deadEnds + unseen < t.minDeadEnds) { s.verdict = MazeScore::DEAD_ENDS; return false; }
+        if (s.corridors + unseen < minCorridors) { s.verdict = MazeScore::RIVER; return false; }
+    }
+    if (s.pathLen < 0) { s.verdict = MazeScore::PATH; return false; }
+    return true;
+}
+
+/* ---------- Command line: constrained generation ---------- */
+// maze_demo --constrain COUNT W H [SEED] [path=MIN-MAX] [deadends=N]
+//                       [river=F] [tries=N] [out=DIR]
+// Candidates from seeds SEED, SEED+1, ... are generated and scored on
+// worker threads a block at a time; the first COUNT that pass, in seed
+// order, are kept (and saved as DIR/maze-SEED.maze). Gives up after
+// `tries` candidates (default 100 * COUNT).
+int runConstrainCommand(int argc, char **argv) {
+    auto usage = [&]() {
+        cerr << "usage: " << argv[0] << " --constrain COUNT W H [SEED] [path=MIN-MAX] [deadends=N]"
+                " [river=F] [tries=N] [out=DIR]\n";
+        return 2;
+    };
+    if (argc < 5) return usage();
+    int count = atoi(argv[2]), W = atoi(argv[3]), H = atoi(argv[4]);
+    if (count < 1 || W < 1 || H < 1 || needsWideIndex(W, H)) {
+        cerr << "COUNT, W and H must be positive and W * H below 2^31\n";
+        return 2;
+    }
+    unsigned seed = (unsigned)time(NULL);
+    int next = 5;
+    if (argc > 5 && !strchr(argv[5], '=')) seed = (unsigned)strtoul(argv[next++], nullptr, 10);
+    MazeTargets t;
+    uint64_t maxTries = 100ULL * count;
+    string outDir;
+    for (; next < argc; next++) {
+        string arg = argv[next];
+        size_t eq = arg.find('=');
+        if (eq == string::npos) return usage();
+        string key = arg.substr(0, eq), val = arg.substr(eq + 1);
+        if (key == "path") {
+            size_t dash = val.find('-');
+            if (dash == string::npos) return usage();
+            if (dash > 0) t.pathMin = atoi(val.substr(0, dash).c_str());
+            if (dash + 1 < val.size()) t.pathMax = atoi(val.substr(dash + 1).c_str());
+        }
+        else if (key == "deadends") t.minDeadEnds = atoi(val.c_str());
+        else if (key == "river") t.minRiver = atof(val.c_str());
+        else if (key == "tries") maxTries = max(1LL, atoll(val.c_str()));
+        else if (key == "out") outDir = val;
+        else return usage();
+    }
+
+    struct Accepted { uint64_t index; MazeScore score; };
+    const int BLOCK = 1024;
+    int threads = max(1, (int)thread::hardware_concurrency());
+    vector<Accepted> kept;
+    uint64_t tried = 0, rejected[4] = {};
+    auto t0 = chrono::steady_clock::now();
+    while ((int)kept.size() < count && tried < maxTries) {
+        int n = (int)min<uint64_t>(BLOCK, maxTries - tried);
+        vector<MazeScore> scores(n);
+        vector<char> pass(n);
+        atomic<int> nextIdx{ 0 };
+        vector<thread> pool;
+        for (int th = 0; th < threads; th++) {
+            pool.emplace_back([&]() {
+                vector<int> dist, que;
+                for (int i; (i = nextIdx.fetch_add(1)) < n; ) {
+                    Maze mz(W, H);
+                    generateMaze(mz, seed + (unsigned)(tried + i));
+                    pass[i] = scoreMaze(mz, t, scores[i], dist, que);
+                }
+            });
+        }
+        for (auto &th : pool) th.join();
+        for (int i = 0; i < n; i++) {
+            if (!pass[i]) rejected[scores[i].verdict]++;
+            else if ((int)kept.size() < count) kept.push_back({ tried + i, scores[i] });
+        }
+        tried += n;
+    }
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    uint64_t accepted = tried - rejected[1] - rejected[2] - rejected[3];
+    double sumPath = 0, sumDead = 0, sumRiver = 0;
+    for (const Accepted &a : kept) {
+        sumPath += a.score.pathLen;
+        sumDead += a.score.deadEnds;
+        sumRiver += (double)a.score.corridors / ((double)W * H);
+    }
+    char buf[320];
+    snprintf(buf, sizeof buf,
+             "%llu of %llu %dx%d candidates accepted (%.2f%%) in %.1f ms: %.0f candidates/s, "
+             "%.0f accepted/s\nrejected: %llu path, %llu dead ends, %llu river\n",
+             (unsigned long long)accepted, (unsigned long long)tried, W, H,
+             100.0 * accepted / max<uint64_t>(tried, 1), secs * 1000, tried / max(secs, 1e-9),
+             accepted / max(secs, 1e-9), (unsigned long long)rejected[MazeScore::PATH],
+             (unsigned long long)rejected[MazeScore::DEAD_ENDS], (unsigned long long)rejected[MazeScore::RIVER]);
+    cout << buf;
+    if (!kept.empty()) {
+        // Without a count target the scan stops at the goal, so only the
+        // path length is complete.
+        if (t.minDeadEnds > 0 || t.minRiver > 0)
+            snprintf(buf, sizeof buf, "kept %zu: mean path %.1f, mean dead ends %.1f, mean river %.3f\n",
+                     kept.size(), sumPath / kept.size(), sumDead / kept.size(), sumRiver / kept.size());
+        else
+            snprintf(buf, sizeof buf, "kept %zu: mean path %.1f\n", kept.size(), sumPath / kept.size());
+        cout << buf;
+    }
+    if ((int)kept.size() < count)
+        cerr << "only " << kept.size() << " of " << count << " mazes met the targets in " << tried << " tries\n";
+
+    if (!outDir.empty()) {
+#ifndef _WIN32
+        mkdir(outDir.c_str(), 0755);
+#endif
+        for (const Accepted &a : kept) {
+            unsigned s = seed + (unsigned)a.index;
+            Maze mz(W, H);
+            generateMaze(mz, s);
+            string path = outDir + "/maze-" + to_string(s) + ".maze";
+            if (!saveMazeFile(path, mz)) {
+                cerr << "cannot write " << path << "\n";
+                return 1;
+            }
+        }
+    }
+    return (int)kept.size() < count ? 1 : 0;
+}
+
+/* ---------- MovingAI grid benchmarks ---------- */
+// Maps and scenarios in the MovingAI benchmark format. A .map file is a
+// short header ("type octile", "height H", "width W", "map") and H rows
+// of terrain characters, of which '.', 'G' and 'S' are passable. Each
+// .scen line is: bucket, map, width, height, start x/y, goal x/y and the
+// optimal octile length (8-connected, diagonals cost sqrt 2 and may not
+// cut a blocked corner).
+struct GridMap {
+    int mazeW = 0, mazeH = 0;     // named like Maze's so PathScratch can search it
+    vector<uint8_t> open;
+
+    bool passable(int x, int y) const {
+        return x >= 0 && y >= 0 && x < mazeW && y < mazeH && open[(size_t)y * mazeW + x];
+    }
+    // 4-connected moves for BasicPathScratch::search; searches only ever
+    // stand on passable cells, so checking the target is enough.
+    bool canMove(int x, int y, int dir) const {
+        return passable(x + (dir==1) - (dir==3), y + (dir==2) - (dir==0));
+    }
+
+    bool load(const string &path, string &err) {
+        ifstream in(path);
+        if (!in) { err = "cannot open " + path; return false; }
+        string word;
+        mazeW = mazeH = 0;
+        while (in >> word && word != "map") {
+            if (word == "height") in >> mazeH;
+            else if (word == "width") in >> mazeW;
+            else if (word == "type") in >> word;
+        }
+        if (word != "map" || mazeW < 1 || mazeH < 1 || needsWideIndex(mazeW, mazeH)) {
+            err = path + ": not a MovingAI map";
+            return false;
+        }
+        open.assign((size_t)mazeW * mazeH, 0);
+        string row;
+        getline(in, row);
+        for (int y = 0; y < mazeH; y++) {
+            if (!getline(in, row) || (int)row.size() < mazeW) {
+                err = path + ": row " + to_string(y) + " is short";
+                return false;
+            }
+            for (int x = 0; x < mazeW; x++) {
+                char c = row[x];
+                open[(size_t)y * mazeW + x] = c == '.' || c == 'G' || c == 'S';
+            }
+        }
+        return true;
+    }
+};
+
+struct Scenario {
+    int bucket, width, height, sx, sy, gx, gy;
+    string map;
+    double optimal;
+};
+
+bool loadScenarios(const string &path, vector<Scenario> &out, string &err) {
+    ifstream in(path);
+    string line;
+    if (!in || !getline(in, line) || line.compare(0, 7, "version") != 0) {
+        err = path + ": not a MovingAI scenario file";
+        return false;
+    }
+    for (int lineNo = 2; getline(in, line); lineNo++) {
+        if (line.find_first_not_of(" \t\r") == string::npos) continue;
+        // Tab-separated, so map paths may hold spaces.
+        vector<string> f;
+        for (size_t at = 0; at <= line.size(); ) {
+            size_t tab = line.find('\t', at);
+            if (tab == string::npos) tab = line.size();
+            f.push_back(line.substr(at, tab - at));
+            at = tab + 1;
+        }
+        if (f.size() < 9) {
+            err = path + ":" + to_string(lineNo) + ": expected 9 tab-separated fields";
+            return false;
+        }
+        Scenario s;
+        s.bucket = atoi(f[0].c_str());
+        s.map = f[1];
+        s.width = atoi(f[2].c_str());
+        s.height = atoi(f[3].c_str());
+        s.sx = atoi(f[4].c_str());
+        s.sy = atoi(f[5].c_str());
+        s.gx = atoi(f[6].c_str());
+        s.gy = atoi(f[7].c_str());
+        s.optimal = atof(f[8].c_str());
+        out.push_back(s);
+    }
+    return true;
+}
+
+/* ---------- Octile Dijkstra / A* on a GridMap ---------- */
+// One instance per map, reused across its scenarios: g lives in a
+// PagedArray reset per query, so each query pays only for the cells it
+// touches. A* uses the octile distance, which is consistent here. With
+// diagonals off it is a 4-connected search (A* then uses Manhattan
+// distance), the exact reference for BFS.
+struct OctileSearch {
+    static constexpr double SQRT2 = 1.4142135623730951;
+    const GridMap &grid;
+    PagedArray<double> g;
+    long long expanded = 0;
+
+    explicit OctileSearch(const GridMap &m)
+        : grid(m), g((size_t)m.mazeW * m.mazeH, numeric_limits<double>::infinity()) {}
+
+    // Length of a shortest path, or -1 if the goal is unreachable.
+    double run(int sx, int sy, int gx, int gy, bool astar, bool diagonals = true) {
+        int W = grid.mazeW, goal = cellId(gx, gy, W);
+        auto h = [&](int x, int y) {
+            if (!astar) return 0.0;
+            int dx = abs(x - gx), dy = abs(y - gy);
+            if (!diagonals) return (double)(dx + dy);
+            return (double)(max(dx, dy) - min(dx, dy)) + SQRT2 * min(dx, dy);
+        };
+        using P = pair<double,int>;
+        priority_queue<P, vector<P>, greater<P>> pq;
+        g.reset();
+        expanded = 0;
+        int start = cellId(sx, sy, W);
+        g[start] = 0;
+        pq.push({ h(sx, sy), start });
+        while (!pq.empty()) {
+            P top = pq.top(); pq.pop();
+            int u = top.second;
+            Point pu = cellPt(u, W);
+            double gu = g[u];
+            if (top.first > gu + h(pu.x, pu.y)) continue;
+            expanded++;
+            if (u == goal) return gu;
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    if ((dx == 0 && dy == 0) || !grid.passable(pu.x + dx, pu.y + dy)) continue;
+                    if (dx != 0 && dy != 0 && (!diagonals ||
+                        !grid.passable(pu.x + dx, pu.y) || !grid.passable(pu.x, pu.y + dy))) continue;
+                    int v = cellId(pu.x + dx, pu.y + dy, W);
+                    double alt = gu + (dx != 0 && dy != 0 ? SQRT2 : 1.0);
+                    if (alt < g[v]) {
+                        g[v] = alt;
+                        pq.push({ alt + h(pu.x + dx, pu.y + dy), v });
+                    }
+                }
+            }
+        }
+        return -1;
+    }
+};
+
+/* ---------- Command line: MovingAI scenarios ---------- */
+// maze_demo --scen FILE.scen [maps=DIR] [algos=bfs,dijkstra,astar] [csv=OUT]
+// Maps are looked up as DIR/<map file name>, by default next to the
+// scenario file, then as written in the scenario. Dijkstra and A* must
+// match each scenario's optimal octile length. BFS searches the same grid
+// 4-connected, so it must match an untimed 4-connected Dijkstra instead
+// (and be no shorter than the octile optimum). "expanded" counts cells
+// taken off the queue for all three. csv=OUT writes one row per scenario
+// and algorithm.
+int runScenCommand(int argc, char **argv) {
+    auto usage = [&]() {
+        cerr << "usage: " << argv[0] << " --scen FILE.scen [maps=DIR] [algos=bfs,dijkstra,astar] [csv=OUT]\n";
+        return 2;
+    };
+    if (argc < 3) return usage();
+    string scenPath = argv[2], slash = "/";
+    size_t cut = scenPath.find_last_of("/\\");
+    string mapDir = cut == string::npos ? "." : scenPath.substr(0, cut), csvPath;
+    bool run[3] = { true, true, true };
+    const char *algoNames[3] = { "bfs", "dijkstra", "astar" };
+    for (int i = 3; i < argc; i++) {
+        string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (eq == string::npos) return usage();
+        string key = arg.substr(0, eq), val = arg.substr(eq + 1);
+        if (key == "maps") mapDir = val;
+        else if (key == "csv") csvPath = val;
+        else if (key == "algos") {
+            for (int a = 0; a < 3; a++) run[a] = (',' + val + ',').find(string(",") + algoNames[a] + ",") != string::npos;
+        }
+        else return usage();
+    }
+
+    vector<Scenario> scens;
+    string err;
+    if (!loadScenarios(scenPath, scens, err)) {
+        cerr << err << "\n";
+        return 1;
+    }
+    FILE *csv = nullptr;
+    if (!csvPath.empty()) {
+        csv = fopen(csvPath.c_str(), "w");
+        if (!csv) {
+            cerr << "cannot write " << csvPath << "\n";
+            return 1;
+        }
+        fprintf(csv, "id,bucket,map,algo,optimal,length,us,expanded,ok\n");
+    }
+
+    struct AlgoStats { long long runs = 0, mismatches = 0, expanded = 0; double totalUs = 0, maxUs = 0; };
+    AlgoStats stats[3];
+    string loadedName;
+    unique_ptr<GridMap> grid;
+    unique_ptr<PathScratch> bfs;
+    unique_ptr<OctileSearch> octile;
+    for (size_t id = 0; id < scens.size(); id++) {
+        const Scenario &s = scens[id];
+        if (s.map != loadedName) {
+            size_t base = s.map.find_last_of("/\\");
+            string name = base == string::npos ? s.map : s.map.substr(base + 1);
+            grid.reset(new GridMap());
+            if (!grid->load(mapDir + slash + name, err) && !grid->load(s.map, err)) {
+                cerr << err << "\n";
+                return 1;
+            }
+            loadedName = s.map;
+            bfs.reset(new PathScratch(grid->mazeW * grid->mazeH));
+            octile.reset(new OctileSearch(*grid));
+        }
+        if (s.width != grid->mazeW || s.height != grid->mazeH || !grid->passable(s.sx, s.sy) ||
+            !grid->passable(s.gx, s.gy)) {
+            cerr << scenPath << ": scenario " << id << " does not fit " << s.map << "\n";
+            return 1;
+        }
+        for (int a = 0; a < 3; a++) {
+            if (!run[a]) continue;
+            auto t0 = chrono::steady_clock::now();
+            double len;
+            long long expanded;
+            if (a == 0) {
+                int W = grid->mazeW;
+                len = bfs->search(*grid, cellId(s.sx, s.sy, W), cellId(s.gx, s.gy, W));
+                expanded = (long long)bfs->expanded;
+            } else {
+                len = octile->run(s.sx, s.sy, s.gx, s.gy, a == 2);
+                expanded = octile->expanded;
+            }
+            double us = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count();
+            double tol = 1e-4 * max(1.0, s.optimal);
+            bool ok = len >= 0;
+            if (a == 0) ok = ok && len >= s.optimal - tol && len == octile->run(s.sx, s.sy, s.gx, s.gy, false, false);
+            else        ok = ok && fabs(len - s.optimal) <= tol;
+            AlgoStats &st = stats[a];
+            st.runs++;
+            st.mismatches += !ok;
+            st.expanded += expanded;
+            st.totalUs += us;
+            st.maxUs = max(st.maxUs, us);
+            if (csv)
+                fprintf(csv, "%zu,%d,%s,%s,%.8f,%.8f,%.2f,%lld,%d\n", id, s.bucket, s.map.c_str(),
+                        algoNames[a], s.optimal, len, us, expanded, ok ? 1 : 0);
+        }
+    }
+    if (csv) fclose(csv);
+
+    long long mismatches = 0;
+    for (int a = 0; a < 3; a++) {
+        const AlgoStats &st = stats[a];
+        if (!st.runs) continue;
+        char buf[200];
+        snprintf(buf, sizeof buf, "%-8s %lld scenarios, %lld mismatches, %.1f ms total, %.1f us mean, "
+                 "%.1f us max, %.0f expanded mean\n", algoNames[a], st.runs, st.mismatches,
+                 st.totalUs / 1000, st.totalUs / st.runs, st.maxUs, (double)st.expanded / st.runs);
+        cout << buf;
+        mismatches += st.mismatches;
+    }
+    return mismatches ? 1 : 0;
+}
+
+/* ---------- Print Legend ---------- */
+void printLegend() {
+    ansiClear();
+    cout << "Legend:\n";
+    cout << COLOR_CORNER << "+ " << COLOR_RESET << ": corner of wall\n";
+    cout << COLOR_HORIZ  << "- " << COLOR_RESET << ": horizontal wall\n";
+    cout << COLOR_VERT   << "| " << COLOR_RESET << ": vertical wall\n";
+    cout << COLOR_VISIT  << ". " << COLOR_RESET << ": visited cell (white)\n";
+    cout << COLOR_FRONT  << "o " << COLOR_RESET << ": frontier (yellow)\n";
+    cout << COLOR_CUR    << "@ " << COLOR_RESET << ": current cell (red)\n";
+    cout << COLOR_PATH   << "* " << COLOR_RESET << ": final path (green)\n";
+    cout << "\nPress Enter to continue...\n";
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+}
+
+/* ---------- Prompt for speed (faster top speed) ---------- */
+void promptSpeed() {
+    int s;
+    while (true) {
+        ansiClear();
+        cout << "Choose speed (1=slow ... 10=fast): ";
+        if (!(cin >> s)) {
+            cin.clear();
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            continue;
+        }
+        if (s >= 1 && s <= 10) break;
+    }
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+
+    switch (s) {
+        case 1:  g_delayMs = 500; break;
+        case 2:  g_delayMs = 300; break;
+        case 3:  g_delayMs = 200; break;
+        case 4:  g_delayMs = 100; break;
+        case 5:  g_delayMs = 80;  break;
+        case 6:  g_delayMs = 60;  break;
+        case 7:  g_delayMs = 40;  break;
+        case 8:  g_delayMs = 25;  break;
+        case 9:  g_delayMs = 10;  break;
+        case 10: g_delayMs = 1;   break;  // Top speed → 1 ms delay
+        default: g_delayMs = 150; break;
+    }
+}
+
+/* ---------- Prompt for the anytime search deadline ---------- */
+int promptDeadline() {
+    ansiClear();
+    cout << "Search deadline in milliseconds (Enter for 100): ";
+    string line;
+    getline(cin, line);
+    int ms = atoi(line.c_str());
+    return ms > 0 ? ms : 100;
+}
+
+/* ---------- Main Program ---------- */
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        string mode = argv[1];
+        if (mode == "--batch") return runBatchCommand(argc, argv);
+        if (mode == "--save") return runSaveCommand(argc, argv);
+        if (mode == "--solve") return runSolveCommand(argc, argv);
+        if (mode == "--constrain") return runConstrainCommand(argc, argv);
+        if (mode == "--scen") return runScenCommand(argc, argv);
+#ifndef _WIN32
+        if (mode == "--serve") return runServeCommand(argc, argv);
+        if (mode == "--query") return runQueryCommand(argc, argv);
+        if (mode == "--shard") return runShardCommand(argc, argv);
+#endif
+        cerr << "unknown option " << mode << "\n";
+        return 2;
+    }
+
+    // Hide the cursor (ANSI code)
+    cout << "\x1b[?25l";
+
+    int mazeWidth = 30, mazeHeight = 15;
+
+    MazePool pool(mazeWidth, mazeHeight);
+    bool userSkips = false;
+
+    while (true) {
+        // ── Take a new maze (normally already generated in the background) ──
+        ReadyMaze ready = pool.take();
+        Maze &mazeObj = *ready.maze;
+        Speculation speculation(mazeObj);
+
+        // Show the empty maze immediately after generation
+        {
+            const AsciiCanvas &canvas = *ready.canvas;
+            // Ensure terminal is large enough
+            while (true) {
+                auto sz = getTerminalSize();
+                int t_rows = sz.first, t_cols = sz.second;
+                int need_rows = canvas.rows + 1;
+                int need_cols = canvas.cols;
+                if (t_rows >= need_rows && t_cols >= need_cols) break;
+                ansiClear();
+                cout << "Terminal too small. Please resize to at least "
+                     << need_cols << "x" << need_rows << ".\n";
+                this_thread::sleep_for(chrono::milliseconds(200));
+            }
+            // Draw empty maze (no visits, no frontier, no current)
+            ansiClear();
+            // Status line for empty maze
+            cout << "EMPTY MAZE - use terminal commands to continue\n";
+            for (int r = 0; r < canvas.rows; r++) {
+                for (int c = 0; c < canvas.cols; c++) {
+                    char ch = canvas.baseGrid[r][c];
+                    switch (ch) {
+                        case '+': cout << COLOR_CORNER << ch << COLOR_RESET; break;
+                        case '-': cout << COLOR_HORIZ  << ch << COLOR_RESET; break;
+                        case '|': cout << COLOR_VERT   << ch << COLOR_RESET; break;
+                        default:  cout << ch;
+                    }
+                }
+                cout << "\n";
+            }
+            cout << "\nPress Enter to continue...\n";
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        }
+
+        // Loop: allow running different algorithms on the same maze
+        while (true) {
+            ansiClear();
+            cout << "Maze " << mazeWidth << "x" << mazeHeight << " generated\n"
+                 << "1) DFS   2) BFS   3) Dijkstra   4) A*\n"
+                 << "5) Wall follower   6) Tremaux   7) Bit-parallel BFS\n"
+                 << "8) Dead-end filling   9) A* with landmarks (ALT)\n"
+                 << "a) Anytime A* (ARA*) with a deadline   b) Bidirectional A*\n"
+                 << "h) Hash-distributed parallel A* (HDA*)   r) Race all four solvers\n"
+                 << "q) Quit\n> ";
+            char choice;
+            cin >> choice;
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            if (choice == 'q' || choice == 'Q') {
+                // Show cursor again before exiting
+                cout << "\x1b[?25h";
+                return 0;
+            }
+
+            // Once the user has skipped an animation, solve ahead while the
+            // legend and prompts are up; until then nothing runs in the background.
+            if (userSkips && Speculation::covers(choice)) speculation.start();
+
+            // Print legend
             printLegend();
 
             // ── ASK WHETHER TO SKIP ANIMATION ──
-            ansiClear();
-            cout << "Press 's' (then Enter) to skip animation, or just press Enter to set speed: ";
+            // HDA* has no animation (it only draws its result), so it asks nothing.
             bool skipAnim = false;
-            string tmp;
-            getline(cin, tmp);
-            if (!tmp.empty() && (tmp[0] == 's' || tmp[0] == 'S')) {
-                skipAnim = true;
-            }
+            if (choice != 'h' && choice != 'H') {
+                ansiClear();
+                cout << "Press 's' (then Enter) to skip animation, or just press Enter to set speed: ";
+                string tmp;
+                getline(cin, tmp);
+                if (!tmp.empty() && (tmp[0] == 's' || tmp[0] == 'S')) {
+                    skipAnim = true;
+                    userSkips = true;
+                }
 
-            // If not skipping, ask for speed
-            if (!skipAnim) {
-                promptSpeed();
+                // If not skipping, ask for speed
+                if (!skipAnim) {
+                    promptSpeed();
+                }
             }
 
+            // Anytime A*, HDA* and race time themselves: let them run alone.
+            if (!Speculation::covers(choice)) speculation.pause();
+
             // Run the chosen algorithm
-            if (choice == '1') {
+            if (skipAnim && Speculation::covers(choice)) {
+                const SolveOutcome &out = speculation.get(choice);
+                drawFinalCells(*ready.canvas, out.cells, out.status);
+            }
+            else if (choice == '1') {
                 runDFS(mazeObj, skipAnim);
             }
             else if (choice == '2') {
@@ -676,6 +4361,43 @@ int main() {
                 };
                 runPQ(mazeObj, manH, "A*", skipAnim);
             }
+            else if (choice == '5') {
+                runLowMemory(mazeObj, false, skipAnim);
+            }
+            else if (choice == '6') {
+                runLowMemory(mazeObj, true, skipAnim);
+            }
+            else if (choice == '7') {
+                runBitBFS(mazeObj, skipAnim);
+            }
+            else if (choice == '8') {
+                runDeadEndFill(mazeObj, skipAnim);
+            }
+            else if (choice == '9') {
+                // Landmarks are built once per maze and reused by later runs.
+                AltHeuristic altH{ &speculation.landmarks(), cellId(mazeWidth - 1, mazeHeight - 1, mazeWidth) };
+                runPQ(mazeObj, altH, "A* (ALT)", skipAnim);
+            }
+            else if (choice == 'a' || choice == 'A') {
+                auto manH = [&](int v) {
+                    Point p = cellPt(v, mazeWidth);
+                    return abs(p.x - (mazeWidth - 1)) + abs(p.y - (mazeHeight - 1));
+                };
+                runAnytime(mazeObj, manH, promptDeadline(), skipAnim);
+            }
+            else if (choice == 'b' || choice == 'B') {
+                runBidirectional(mazeObj, skipAnim);
+            }
+            else if (choice == 'h' || choice == 'H') {
+                auto manH = [&](int v) {
+                    Point p = cellPt(v, mazeWidth);
+                    return abs(p.x - (mazeWidth - 1)) + abs(p.y - (mazeHeight - 1));
+                };
+                runParallelAStar(mazeObj, manH);
+            }
+            else if (choice == 'r' || choice == 'R') {
+                runRace(mazeObj, skipAnim);
+            }
             else {
                 // Invalid input → back to algorithm menu
                 continue;
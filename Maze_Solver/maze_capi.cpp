@@ -0,0 +1,149 @@
+// maze_capi.cpp — C ABI over maze_core.h (see maze_capi.h for the build line)
+// No exception crosses the boundary: allocation failures become
+// MAZE_ERR_MEMORY and everything else is checked up front.
+
+#define MAZE_BUILD_DLL
+#include "maze_capi.h"
+#include "maze_core.h"
+
+#include <limits>
+#include <new>
+
+struct MazeHandle {
+    Maze maze;
+    // Made by the first solve; 64-bit ids only past INT32_MAX cells.
+    std::unique_ptr<PathScratch> scratch;
+    std::unique_ptr<BasicPathScratch<int64_t>> wideScratch;
+
+    MazeHandle(Maze &&mz) : maze(std::move(mz)) {}
+};
+
+static bool validSize(int width, int height) {
+    return width >= 1 && height >= 1;
+}
+
+template<typename Index, typename Cell>
+static int solveWith(std::unique_ptr<BasicPathScratch<Index>> &scratch, const Maze &mz,
+                     int fromX, int fromY, int toX, int toY,
+                     Cell *cells, size_t capacity, size_t *length) {
+    try {
+        if (!scratch) scratch.reset(new BasicPathScratch<Index>((Index)mz.mazeW * mz.mazeH));
+    } catch (const std::bad_alloc &) {
+        return MAZE_ERR_MEMORY;
+    }
+    Index to = cellIndex<Index>(toX, toY, mz.mazeW);
+    Index d = scratch->search(mz, cellIndex<Index>(fromX, fromY, mz.mazeW), to);
+    if (d < 0) return MAZE_ERR_NO_PATH;
+    *length = (size_t)d + 1;
+    if (capacity < *length) return MAZE_ERR_BUFFER;
+    size_t at = *length;
+    for (Index v = to; v != -1; v = scratch->parent[v]) cells[--at] = (Cell)v;
+    return MAZE_OK;
+}
+
+template<typename Cell>
+static int solveChecked(MazeHandle *maze, int fromX, int fromY, int toX, int toY,
+                        Cell *cells, size_t capacity, size_t *length) {
+    if (length) *length = 0;
+    if (!maze || !length || (!cells && capacity > 0)) return MAZE_ERR_ARGUMENT;
+    const Maze &mz = maze->maze;
+    int W = mz.mazeW, H = mz.mazeH;
+    if (fromX < 0 || fromY < 0 || toX < 0 || toY < 0 || fromX >= W || toX >= W || fromY >= H || toY >= H)
+        return MAZE_ERR_ARGUMENT;
+    if ((uint64_t)W * H - 1 > (uint64_t)std::numeric_limits<Cell>::max()) return MAZE_ERR_ARGUMENT;
+    if (needsWideIndex(W, H))
+        return solveWith(maze->wideScratch, mz, fromX, fromY, toX, toY, cells, capacity, length);
+    return solveWith(maze->scratch, mz, fromX, fromY, toX, toY, cells, capacity, length);
+}
+
+extern "C" {
+
+int maze_api_version(void) { return MAZE_API_VERSION; }
+
+const char *maze_status_string(int status) {
+    switch (status) {
+        case MAZE_OK:           return "ok";
+        case MAZE_ERR_ARGUMENT: return "invalid argument";
+        case MAZE_ERR_IO:       return "cannot read or write maze file";
+        case MAZE_ERR_NO_PATH:  return "no path";
+        case MAZE_ERR_BUFFER:   return "buffer too small";
+        case MAZE_ERR_MEMORY:   return "out of memory";
+        default:                return "unknown status";
+    }
+}
+
+int maze_create(int width, int height, MazeHandle **out) {
+    if (!out) return MAZE_ERR_ARGUMENT;
+    *out = nullptr;
+    if (!validSize(width, height)) return MAZE_ERR_ARGUMENT;
+    try {
+        *out = new MazeHandle(Maze(width, height));
+    } catch (const std::bad_alloc &) {
+        return MAZE_ERR_MEMORY;
+    }
+    return MAZE_OK;
+}
+
+void maze_free(MazeHandle *maze) { delete maze; }
+
+int maze_generate(MazeHandle *maze, uint32_t seed) {
+    if (!maze) return MAZE_ERR_ARGUMENT;
+    try {
+        Maze fresh(maze->maze.mazeW, maze->maze.mazeH);
+        fresh.generateRandom(seed);
+        maze->maze = std::move(fresh);
+    } catch (const std::bad_alloc &) {
+        return MAZE_ERR_MEMORY;
+    }
+    return MAZE_OK;
+}
+
+int maze_braid(MazeHandle *maze, uint32_t seed, double fraction) {
+    if (!maze || !(fraction >= 0 && fraction <= 1)) return MAZE_ERR_ARGUMENT;
+    maze->maze.braid(seed, fraction);
+    return MAZE_OK;
+}
+
+int maze_width(const MazeHandle *maze) { return maze ? maze->maze.mazeW : MAZE_ERR_ARGUMENT; }
+int maze_height(const MazeHandle *maze) { return maze ? maze->maze.mazeH : MAZE_ERR_ARGUMENT; }
+
+int maze_can_move(const MazeHandle *maze, int x, int y, int dir) {
+    if (!maze || x < 0 || y < 0 || x >= maze->maze.mazeW || y >= maze->maze.mazeH || dir < 0 || dir > 3)
+        return MAZE_ERR_ARGUMENT;
+    return maze->maze.canMove(x, y, dir) ? 1 : 0;
+}
+
+int maze_save(const MazeHandle *maze, const char *path) {
+    if (!maze || !path) return MAZE_ERR_ARGUMENT;
+    try {
+        return saveMazeFile(path, maze->maze) ? MAZE_OK : MAZE_ERR_IO;
+    } catch (const std::bad_alloc &) {
+        return MAZE_ERR_MEMORY;
+    }
+}
+
+int maze_load(const char *path, MazeHandle **out) {
+    if (!out || !path) return MAZE_ERR_ARGUMENT;
+    *out = nullptr;
+    try {
+        MazeView view;
+        std::string err;
+        if (!view.load(path, err)) return MAZE_ERR_IO;
+        *out = new MazeHandle(mazeFromView(view));
+    } catch (const std::bad_alloc &) {
+        return MAZE_ERR_MEMORY;
+    }
+    return MAZE_OK;
+}
+
+int maze_solve(MazeHandle *maze, int fromX, int fromY, int toX, int toY,
+               uint32_t *cells, size_t capacity, size_t *length) {
+    return solveChecked(maze, fromX, fromY, toX, toY, cells, capacity, length);
+}
+
+int maze_solve64(MazeHandle *maze, int fromX, int fromY, int toX, int toY,
+                 uint64_t *cells, size_t capacity, size_t *length) {
+    return solveChecked(maze, fromX, fromY, toX, toY, cells, capacity, length);
+}
+
+}  // extern "C"
@@ -0,0 +1,80 @@
+/* maze_capi.h — C interface to the maze core (libmaze)
+ *
+ * Build the shared library from this directory with
+ *   g++ -std=c++17 -O2 -shared -fPIC -fvisibility=hidden maze_capi.cpp -o libmaze.so
+ * (on Windows: cl /std:c++17 /O2 /LD /DMAZE_BUILD_DLL maze_capi.cpp).
+ *
+ * Every call returns a MAZE_* status; results go to caller-owned memory.
+ * A handle may be used by one thread at a time; separate handles are
+ * independent. Directions: 0 = up, 1 = right, 2 = down, 3 = left. Cell ids
+ * in paths are y * width + x.
+ */
+#ifndef MAZE_CAPI_H
+#define MAZE_CAPI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+  #ifdef MAZE_BUILD_DLL
+    #define MAZE_API __declspec(dllexport)
+  #else
+    #define MAZE_API __declspec(dllimport)
+  #endif
+#else
+  #define MAZE_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MAZE_API_VERSION 2
+
+enum {
+    MAZE_OK           =  0,
+    MAZE_ERR_ARGUMENT = -1,     /* null handle, bad size or coordinates */
+    MAZE_ERR_IO       = -2,     /* file missing, unreadable or not a maze file */
+    MAZE_ERR_NO_PATH  = -3,
+    MAZE_ERR_BUFFER   = -4,     /* path buffer too small; *length holds the need */
+    MAZE_ERR_MEMORY   = -5
+};
+
+typedef struct MazeHandle MazeHandle;
+
+MAZE_API int maze_api_version(void);
+MAZE_API const char *maze_status_string(int status);
+
+/* A width x height maze with every wall present. */
+MAZE_API int maze_create(int width, int height, MazeHandle **out);
+MAZE_API void maze_free(MazeHandle *maze);
+
+/* Replaces the walls with a perfect maze; the same seed gives the same maze. */
+MAZE_API int maze_generate(MazeHandle *maze, uint32_t seed);
+/* Adds loops: opens one wall of each dead end with probability fraction
+ * (0 to 1), reproducibly from seed. Call after maze_generate. Since v2. */
+MAZE_API int maze_braid(MazeHandle *maze, uint32_t seed, double fraction);
+
+MAZE_API int maze_width(const MazeHandle *maze);
+MAZE_API int maze_height(const MazeHandle *maze);
+/* 1 if the move is open, 0 if walled off or leaving the grid. */
+MAZE_API int maze_can_move(const MazeHandle *maze, int x, int y, int dir);
+
+/* Packed maze files, the format used by `maze --save` and `maze --serve`. */
+MAZE_API int maze_save(const MazeHandle *maze, const char *path);
+MAZE_API int maze_load(const char *path, MazeHandle **out);
+
+/* Shortest path, both end cells included. Pass cells = NULL and
+ * capacity = 0 to ask for the length only. maze_solve needs every cell id
+ * to fit in 32 bits (MAZE_ERR_ARGUMENT otherwise); maze_solve64 takes
+ * mazes of any size. */
+MAZE_API int maze_solve(MazeHandle *maze, int fromX, int fromY, int toX, int toY,
+                        uint32_t *cells, size_t capacity, size_t *length);
+MAZE_API int maze_solve64(MazeHandle *maze, int fromX, int fromY, int toX, int toY,
+                          uint64_t *cells, size_t capacity, size_t *length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MAZE_CAPI_H */
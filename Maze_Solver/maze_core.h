@@ -0,0 +1,922 @@
+// maze_core.h — Maze generation, packed maze files and shortest paths
+// Terminal-free core shared by the interactive solver (main.cpp) and the
+// C API in maze_capi.cpp. Header-only; everything is std-qualified so it
+// can be included ahead of a `using namespace std`.
+
+#ifndef MAZE_CORE_H
+#define MAZE_CORE_H
+
+#ifndef _WIN32
+  #include <sys/mman.h>   // Mapped maze files, huge-page allocation
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <pthread.h>    // Thread pinning for first-touch placement
+#endif
+
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <memory>
+#include <new>
+#include <thread>
+#include <chrono>
+#include <type_traits>
+#include <ctime>
+#include <cstdint>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/* ---------- Cell index type ---------- */
+// Cell ids are y * W + x. 32-bit ids are the default and keep solver
+// arrays dense; mazes past INT32_MAX cells switch to 64-bit ids.
+inline bool needsWideIndex(int W, int H) { return (int64_t)W * H > INT32_MAX; }
+
+/* ---------- Disjoint Set (Union‐Find) ---------- */
+template<typename Index>
+struct BasicDisjointSet {
+    std::vector<Index> parent, sz;
+    BasicDisjointSet(Index n) {
+        parent.resize(n);
+        std::iota(parent.begin(), parent.end(), Index(0));
+        sz.assign(n, 1);
+    }
+    Index findRoot(Index x) {
+        return parent[x] == x ? x : (parent[x] = findRoot(parent[x]));
+    }
+    void unite(Index a, Index b) {
+        a = findRoot(a);
+        b = findRoot(b);
+        if (a == b) return;
+        if (sz[a] < sz[b]) std::swap(a, b);
+        parent[b] = a;
+        sz[a] += sz[b];
+    }
+};
+using DisjointSet = BasicDisjointSet<int>;
+
+/* ---------- Helper: cellId ↔ (x,y) ---------- */
+struct Point { int x, y; };
+template<typename Index>
+inline Index cellIndex(int x, int y, int W) { return (Index)y * W + x; }
+template<typename Index>
+inline Point cellPoint(Index idx, int W) { return { (int)(idx % W), (int)(idx / W) }; }
+inline int cellId(int x, int y, int W) { return cellIndex<int>(x, y, W); }
+inline Point cellPt(int idx, int W) { return cellPoint<int>(idx, W); }
+
+/* ---------- Maze Structure & Random Generation ---------- */
+struct Maze {
+    int mazeW, mazeH;
+    std::vector<std::vector<bool>> hasRightWall, hasDownWall;
+
+    Maze(int w, int h): mazeW(w), mazeH(h) {
+        hasRightWall.assign(mazeW, std::vector<bool>(mazeH, true));
+        hasDownWall.assign(mazeW, std::vector<bool>(mazeH, true));
+    }
+
+    void generateRandom() {
+        generateRandom((unsigned)time(NULL));
+    }
+
+    void generateRandom(unsigned seed) {
+        if (needsWideIndex(mazeW, mazeH)) kruskal<int64_t>(seed);
+        else                              kruskal<int>(seed);
+    }
+
+    // The same maze as generateRandom(seed), committing progress to a
+    // checkpoint file now and then and resuming from it if one for this
+    // size and seed exists. Defined after CheckpointFile.
+    bool generateRandom(unsigned seed, const std::string &checkpoint, std::string &err);
+
+    // Edges are packed as cell * 2 + (down ? 1 : 0) in the unsigned index
+    // type; shuffle's draws depend only on the count, so either width gives
+    // the same maze for a seed.
+    template<typename Index>
+    std::vector<typename std::make_unsigned<Index>::type> shuffledEdges(unsigned seed) const {
+        using Edge = typename std::make_unsigned<Index>::type;
+        std::vector<Edge> edges;
+        for (int y = 0; y < mazeH; y++) {
+            for (int x = 0; x < mazeW; x++) {
+                Edge cell = (Edge)cellIndex<Index>(x, y, mazeW);
+                if (x + 1 < mazeW) edges.push_back(cell * 2);
+                if (y + 1 < mazeH) edges.push_back(cell * 2 + 1);
+            }
+        }
+        std::mt19937 rng(seed);
+        std::shuffle(edges.begin(), edges.end(), rng);
+        return edges;
+    }
+
+    // Kruskal over edges[from..]: onJoin(edge) for every edge that joins
+    // two sets. onProgress(done) runs every 64K edges and may commit.
+    template<typename Index, typename Edge, typename OnJoin, typename OnProgress>
+    void joinEdges(const std::vector<Edge> &edges, size_t from, BasicDisjointSet<Index> &ds,
+                   OnJoin onJoin, OnProgress onProgress) const {
+        for (size_t i = from; i < edges.size(); i++) {
+            Edge e = edges[i];
+            Index a = (Index)(e / 2);
+            Index b = (e & 1) ? (a + mazeW) : (a + 1);
+            if (ds.findRoot(a) != ds.findRoot(b)) {
+                onJoin(e);
+                ds.unite(a, b);
+            }
+            if (((i + 1) & 0xFFFF) == 0) onProgress(i + 1);
+        }
+    }
+
+    template<typename Index>
+    void kruskal(unsigned seed) {
+        auto edges = shuffledEdges<Index>(seed);
+        BasicDisjointSet<Index> ds((Index)mazeW * mazeH);
+        joinEdges(edges, 0, ds, [&](uint64_t e) { removeWall(e); }, [](size_t) {});
+    }
+
+    template<typename Index>
+    bool kruskalCheckpointed(unsigned seed, const std::string &checkpoint, std::string &err);
+
+    // Braids the maze: each dead end, visited in row-major order, loses one
+    // wall with probability `fraction` (0..1), preferring a wall into
+    // another dead end so one removal can clear both. This adds loops and
+    // removes dead ends. Draws are raw mt19937 output on a stream derived
+    // from the seed, so the result is the same on every platform.
+    void braid(unsigned seed, double fraction) {
+        std::mt19937 rng(seed ^ 0x9E3779B9u);
+        uint64_t threshold = (uint64_t)(std::min(std::max(fraction, 0.0), 1.0) * 4294967296.0);
+        auto degree = [&](int x, int y) {
+            int d = 0;
+            for (int dir = 0; dir < 4; dir++) d += canMove(x, y, dir);
+            return d;
+        };
+        for (int y = 0; y < mazeH; y++) {
+            for (int x = 0; x < mazeW; x++) {
+                if (degree(x, y) != 1 || rng() >= threshold) continue;
+                int walled[4], deadEnds[4], n = 0, nd = 0;
+                for (int dir = 0; dir < 4; dir++) {
+                    int nx = x + (dir==1) - (dir==3), ny = y + (dir==2) - (dir==0);
+                    if (nx < 0 || nx >= mazeW || ny < 0 || ny >= mazeH || canMove(x, y, dir)) continue;
+                    walled[n++] = dir;
+                    if (degree(nx, ny) == 1) deadEnds[nd++] = dir;
+                }
+                if (n == 0) continue;
+                int dir = nd ? deadEnds[rng() % nd] : walled[rng() % n];
+                uint64_t cell = (uint64_t)y * mazeW + x;
+                if (dir == 0)      removeWall((cell - mazeW) * 2 + 1);
+                else if (dir == 1) removeWall(cell * 2);
+                else if (dir == 2) removeWall(cell * 2 + 1);
+                else               removeWall((cell - 1) * 2);
+            }
+        }
+    }
+
+    void removeWall(uint64_t edge) {
+        uint64_t a = edge / 2;
+        int x = (int)(a % mazeW), y = (int)(a / mazeW);
+        if (edge & 1) hasDownWall[x][y]  = false;
+        else          hasRightWall[x][y] = false;
+    }
+
+    bool canMove(int x, int y, int dir) const {
+        if (dir == 0) {
+            if (y == 0) return false;
+            return !hasDownWall[x][y - 1];
+        }
+        if (dir == 1) {
+            if (x + 1 >= mazeW) return false;
+            return !hasRightWall[x][y];
+        }
+        if (dir == 2) {
+            if (y + 1 >= mazeH) return false;
+            return !hasDownWall[x][y];
+        }
+        if (dir == 3) {
+            if (x == 0) return false;
+            return !hasRightWall[x - 1][y];
+        }
+        return false;
+    }
+};
+
+/* ---------- Huge-page allocation ---------- */
+// Multi-GB wall planes and solver arrays are read at random by BFS/A*, so
+// TLB misses dominate; 2MB pages cut them. MAZE_HUGEPAGES picks the mode:
+// "off" (default), "thp" (madvise for transparent huge pages) or
+// "explicit" (MAP_HUGETLB from the reserved pool, falling back to thp).
+// Blocks under 2MB always come from the normal heap.
+enum class HugePageMode { Off, Transparent, Explicit };
+
+inline HugePageMode hugePageMode() {
+    static const HugePageMode mode = [] {
+        const char *env = std::getenv("MAZE_HUGEPAGES");
+        std::string v = env ? env : "";
+        if (v == "thp") return HugePageMode::Transparent;
+        if (v == "explicit") return HugePageMode::Explicit;
+        return HugePageMode::Off;
+    }();
+    return mode;
+}
+
+static const size_t HUGE_PAGE_BYTES = size_t(2) << 20;
+
+inline bool usesHugePages(size_t bytes) {
+#ifdef _WIN32
+    (void)bytes;
+    return false;
+#else
+    return bytes >= HUGE_PAGE_BYTES && hugePageMode() != HugePageMode::Off;
+#endif
+}
+
+inline size_t hugePageRound(size_t bytes) {
+    return (bytes + HUGE_PAGE_BYTES - 1) & ~(HUGE_PAGE_BYTES - 1);
+}
+
+inline void *allocLarge(size_t bytes) {
+    if (!usesHugePages(bytes)) return ::operator new(bytes);
+#ifdef _WIN32
+    return nullptr;
+#else
+    size_t len = hugePageRound(bytes);
+#ifdef MAP_HUGETLB
+    if (hugePageMode() == HugePageMode::Explicit) {
+        void *p = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) return p;
+    }
+#endif
+    // Over-map by one huge page and trim, so the block is 2MB aligned and
+    // the kernel can back all of it with huge pages.
+    char *raw = (char *)mmap(nullptr, len + HUGE_PAGE_BYTES, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == (char *)MAP_FAILED) throw std::bad_alloc();
+    char *p = (char *)hugePageRound((size_t)raw);
+    if (p > raw) munmap(raw, (size_t)(p - raw));
+    munmap(p + len, (size_t)(raw + HUGE_PAGE_BYTES - p));
+#ifdef MADV_HUGEPAGE
+    madvise(p, len, MADV_HUGEPAGE);
+#endif
+    return p;
+#endif
+}
+
+inline void freeLarge(void *p, size_t bytes) {
+    if (!usesHugePages(bytes)) { ::operator delete(p); return; }
+#ifndef _WIN32
+    munmap(p, hugePageRound(bytes));
+#endif
+}
+
+// Construction without a value leaves memory untouched, so resize() does
+// not fault pages in on the allocating thread; callers must then write
+// every element themselves (see MazeBits).
+template<typename T>
+struct LargePageAllocator {
+    using value_type = T;
+
+    LargePageAllocator() = default;
+    template<typename U> LargePageAllocator(const LargePageAllocator<U> &) {}
+
+    T *allocate(size_t n) { return (T *)allocLarge(n * sizeof(T)); }
+    void deallocate(T *p, size_t n) { freeLarge(p, n * sizeof(T)); }
+
+    template<typename U> void construct(U *p) { ::new ((void *)p) U; }
+    template<typename U, typename... Args>
+    void construct(U *p, Args &&...args) { ::new ((void *)p) U(std::forward<Args>(args)...); }
+
+    template<typename U> bool operator==(const LargePageAllocator<U> &) const { return true; }
+    template<typename U> bool operator!=(const LargePageAllocator<U> &) const { return false; }
+};
+using WordVector = std::vector<uint64_t, LargePageAllocator<uint64_t>>;
+using CellVector = std::vector<int, LargePageAllocator<int>>;
+
+/* ---------- Row bands and NUMA placement ---------- */
+// Row-parallel work splits the grid into one band of rows per thread, and
+// band t always runs on CPU t. Bands of large arrays are first written by
+// the thread that will work on them, so Linux's first-touch policy puts
+// each band on that thread's NUMA node.
+inline int rowBands(int threads, int rows) {
+    return std::max(1, std::min(threads, rows / 16));
+}
+
+inline void pinThreadToCpu(int cpu) {
+#ifdef __linux__
+    int ncpu = std::max(1, (int)std::thread::hardware_concurrency());
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % ncpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof set, &set);
+#else
+    (void)cpu;
+#endif
+}
+
+// Calls fn(y0, y1) for each band, band t on its own thread pinned to CPU t.
+template<typename Fn>
+void forEachBand(int bands, int rows, Fn fn) {
+    if (bands <= 1) { fn(0, rows); return; }
+    std::vector<std::thread> pool;
+    for (int t = 0; t < bands; t++) {
+        pool.emplace_back([=] {
+            pinThreadToCpu(t);
+            fn(rows * t / bands, rows * (t + 1) / bands);
+        });
+    }
+    for (auto &th : pool) th.join();
+}
+
+/* ---------- Packed wall bitmaps (one bitset per row) ---------- */
+// Bit x of row y in openRight / openDown is set when canMove(x, y, 1/2).
+// Every row carries a zero pad word on both sides and the grid carries a
+// zero pad row above and below, so the row kernels never bounds-check.
+// With threads > 1 the rows are filled band by band (see forEachBand).
+struct MazeBits {
+    int mazeW, mazeH, words, stride;
+    WordVector openRight, openDown;
+
+    MazeBits(const Maze &mz, int threads = 1): mazeW(mz.mazeW), mazeH(mz.mazeH) {
+        words  = (mazeW + 63) / 64;
+        stride = words + 2;
+        openRight.resize((size_t)(mazeH + 2) * stride);
+        openDown.resize((size_t)(mazeH + 2) * stride);
+        forEachBand(rowBands(threads, mazeH), mazeH, [&](int y0, int y1) {
+            // The first and last band also own the pad rows.
+            int from = y0 == 0 ? -1 : y0, to = y1 == mazeH ? mazeH + 1 : y1;
+            std::fill(openRight.begin() + rowOffset(from) - 1, openRight.begin() + rowOffset(to) - 1, 0);
+            std::fill(openDown.begin() + rowOffset(from) - 1, openDown.begin() + rowOffset(to) - 1, 0);
+            for (int y = y0; y < y1; y++) {
+                uint64_t *r = rowOf(openRight, y), *d = rowOf(openDown, y);
+                for (int x = 0; x < mazeW; x++) {
+                    if (mz.canMove(x, y, 1)) r[x / 64] |= 1ULL << (x % 64);
+                    if (mz.canMove(x, y, 2)) d[x / 64] |= 1ULL << (x % 64);
+                }
+            }
+        });
+    }
+
+    // First real word of row y (y may be -1 or mazeH for the pad rows).
+    size_t rowOffset(int y) const { return (size_t)(y + 1) * stride + 1; }
+    template<typename Words>
+    auto rowOf(Words &v, int y) const -> decltype(v.data()) { return v.data() + rowOffset(y); }
+};
+
+/* ---------- Packed maze files ---------- */
+// A small header followed by MazeBits' two planes exactly as they sit in
+// memory (pad words and pad rows included), so a loader can map the file
+// and query it in place without building a Maze.
+struct MazeFileHeader {
+    char magic[8];              // "MAZEBIT1"
+    uint32_t width, height;
+};
+static const char MAZE_FILE_MAGIC[8] = { 'M','A','Z','E','B','I','T','1' };
+
+inline size_t mazeImageBytes(int W, int H) {
+    size_t stride = (size_t)(W + 63) / 64 + 2;
+    return sizeof(MazeFileHeader) + 2 * (size_t)(H + 2) * stride * sizeof(uint64_t);
+}
+
+// Writes the file image (header and planes) to dst, which must hold
+// mazeImageBytes() bytes.
+inline void writeMazeImage(void *dst, const MazeBits &mb) {
+    MazeFileHeader hdr;
+    memcpy(hdr.magic, MAZE_FILE_MAGIC, sizeof hdr.magic);
+    hdr.width = (uint32_t)mb.mazeW;
+    hdr.height = (uint32_t)mb.mazeH;
+    char *p = (char *)dst;
+    memcpy(p, &hdr, sizeof hdr);
+    p += sizeof hdr;
+    memcpy(p, mb.openRight.data(), mb.openRight.size() * sizeof(uint64_t));
+    p += mb.openRight.size() * sizeof(uint64_t);
+    memcpy(p, mb.openDown.data(), mb.openDown.size() * sizeof(uint64_t));
+}
+
+inline bool saveMazeFile(const std::string &path, const Maze &mz) {
+    MazeBits mb(mz);
+    std::vector<char> image(mazeImageBytes(mz.mazeW, mz.mazeH));
+    writeMazeImage(image.data(), mb);
+    FILE *f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    bool ok = fwrite(image.data(), 1, image.size(), f) == image.size();
+    return fclose(f) == 0 && ok;
+}
+
+// Read-only view of the two planes, backed by a MazeBits built in memory,
+// a mapped maze file, or any other mapping of a file image (attach).
+struct MazeView {
+    int mazeW = 0, mazeH = 0;
+    size_t stride = 0;
+    const uint64_t *openRight = nullptr, *openDown = nullptr;
+
+    MazeView() {}
+    MazeView(const MazeView &) = delete;
+    MazeView &operator=(const MazeView &) = delete;
+    ~MazeView() { release(); }
+
+    void fromMaze(const Maze &mz) {
+        release();
+        owned.reset(new MazeBits(mz));
+        mazeW = mz.mazeW;
+        mazeH = mz.mazeH;
+        stride = (size_t)owned->stride;
+        openRight = owned->openRight.data();
+        openDown = owned->openDown.data();
+    }
+
+    // Views a file image in memory the caller keeps alive.
+    bool attach(const void *image, size_t len, std::string &err) {
+        release();
+        MazeFileHeader hdr;
+        if (len < sizeof hdr) { err = "not a maze file"; return false; }
+        memcpy(&hdr, image, sizeof hdr);
+        if (memcmp(hdr.magic, MAZE_FILE_MAGIC, sizeof hdr.magic) != 0 ||
+            hdr.width < 1 || hdr.height < 1 || hdr.width > 1000000 || hdr.height > 1000000) {
+            err = "not a maze file";
+            return false;
+        }
+        if (len != mazeImageBytes((int)hdr.width, (int)hdr.height)) {
+            err = "wrong size for " + std::to_string(hdr.width) + "x" + std::to_string(hdr.height);
+            return false;
+        }
+        const uint64_t *planes = (const uint64_t *)((const char *)image + sizeof hdr);
+        mazeW = (int)hdr.width;
+        mazeH = (int)hdr.height;
+        stride = (size_t)(mazeW + 63) / 64 + 2;
+        openRight = planes;
+        openDown = planes + (size_t)(mazeH + 2) * stride;
+        return true;
+    }
+
+    bool load(const std::string &path, std::string &err) {
+        release();
+#ifdef _WIN32
+        FILE *f = fopen(path.c_str(), "rb");
+        if (!f) { err = "cannot open " + path; return false; }
+        fseek(f, 0, SEEK_END);
+        long len = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        std::vector<uint64_t> image(len > 0 ? ((size_t)len + 7) / 8 : 0);
+        bool ok = len > 0 && fread(image.data(), 1, (size_t)len, f) == (size_t)len;
+        fclose(f);
+        if (!ok) { err = "cannot read " + path; return false; }
+        if (!attach(image.data(), (size_t)len, err)) { err = path + ": " + err; return false; }
+        buffer.swap(image);
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) { err = "cannot open " + path; return false; }
+        struct stat st;
+        void *p = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+            p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) { err = "cannot map " + path; return false; }
+        if (!attach(p, (size_t)st.st_size, err)) {
+            munmap(p, (size_t)st.st_size);
+            err = path + ": " + err;
+            return false;
+        }
+        mapped = p;
+        mappedLen = (size_t)st.st_size;
+#endif
+        return true;
+    }
+
+    bool bitAt(const uint64_t *plane, int x, int y) const {
+        return (plane[(size_t)(y + 1) * stride + 1 + x / 64] >> (x % 64)) & 1;
+    }
+    bool canMove(int x, int y, int dir) const {
+        if (dir == 0) return y > 0 && bitAt(openDown, x, y - 1);
+        if (dir == 1) return bitAt(openRight, x, y);
+        if (dir == 2) return bitAt(openDown, x, y);
+        return x > 0 && bitAt(openRight, x - 1, y);
+    }
+
+private:
+    std::unique_ptr<MazeBits> owned;
+    std::vector<uint64_t> buffer;
+    void *mapped = nullptr;
+    size_t mappedLen = 0;
+
+    void release() {
+#ifndef _WIN32
+        if (mapped) munmap(mapped, mappedLen);
+#endif
+        mapped = nullptr;
+        owned.reset();
+        buffer.clear();
+        openRight = openDown = nullptr;
+    }
+};
+
+// Rebuilds the wall representation from a loaded or generated view.
+inline Maze mazeFromView(const MazeView &mv) {
+    Maze mz(mv.mazeW, mv.mazeH);
+    for (int y = 0; y < mv.mazeH; y++) {
+        for (int x = 0; x < mv.mazeW; x++) {
+            mz.hasRightWall[x][y] = !mv.canMove(x, y, 1);
+            mz.hasDownWall[x][y]  = !mv.canMove(x, y, 2);
+        }
+    }
+    return mz;
+}
+
+/* ---------- Maze content hash ---------- */
+// 64-bit hash of the walls: four independent multiply-rotate lanes over
+// the real words of every openRight row, then every openDown row, with the
+// dimensions folded into the seed and an avalanche at the end. Pad words
+// are skipped, so the value depends only on the maze, not on the layout.
+struct MazeHasher {
+    static const uint64_t P1 = 0x9E3779B185EBCA87ULL, P2 = 0xC2B2AE3D27D4EB4FULL,
+                          P3 = 0x165667B19E3779F9ULL;
+    uint64_t lane[4];
+    uint64_t count = 0;
+
+    MazeHasher(int W, int H) {
+        uint64_t seed = ((uint64_t)(uint32_t)W << 32) | (uint32_t)H;
+        lane[0] = seed + P1 + P2;
+        lane[1] = seed + P2;
+        lane[2] = seed;
+        lane[3] = seed - P1;
+    }
+
+    static uint64_t rotl(uint64_t v, int r) { return (v << r) | (v >> (64 - r)); }
+
+    void update(uint64_t word) {
+        uint64_t &a = lane[count++ & 3];
+        a = rotl(a + word * P2, 31) * P1;
+    }
+
+    uint64_t digest() const {
+        uint64_t h = rotl(lane[0], 1) + rotl(lane[1], 7) + rotl(lane[2], 12) + rotl(lane[3], 18);
+        for (uint64_t a : lane) h = (h ^ (rotl(a * P2, 31) * P1)) * P1 + P3;
+        h ^= count;
+        h ^= h >> 33; h *= P2;
+        h ^= h >> 29; h *= P3;
+        h ^= h >> 32;
+        return h;
+    }
+};
+
+// Hash of two planes in MazeBits' layout (pad row above and below, pad
+// word either side of each row).
+inline uint64_t mazePlanesHash(int W, int H, size_t stride,
+                               const uint64_t *openRight, const uint64_t *openDown) {
+    MazeHasher hs(W, H);
+    size_t words = (size_t)(W + 63) / 64;
+    for (const uint64_t *plane : { openRight, openDown }) {
+        for (int y = 0; y < H; y++) {
+            const uint64_t *row = plane + (size_t)(y + 1) * stride + 1;
+            for (size_t i = 0; i < words; i++) hs.update(row[i]);
+        }
+    }
+    return hs.digest();
+}
+
+inline uint64_t mazeHash(const MazeView &mv) {
+    return mazePlanesHash(mv.mazeW, mv.mazeH, mv.stride, mv.openRight, mv.openDown);
+}
+
+inline uint64_t mazeHash(const Maze &mz) {
+    MazeView mv;
+    mv.fromMaze(mz);
+    return mazeHash(mv);
+}
+
+/* ---------- Symmetry-canonical hash ---------- */
+// The 8 symmetries of the grid: bit 2 of `sym` transposes (x, y) -> (y, x),
+// then bit 0 mirrors x and bit 1 mirrors y in the resulting shape.
+// symmetryHash is mazeHash of the maze's image under one of them, built
+// straight into fresh planes; symmetry 0 is the identity and equals
+// mazeHash. canonicalMazeHash takes the smallest of the 8, so mazes that
+// differ only by orientation hash alike. Start and goal are not hashed.
+inline uint64_t symmetryHash(const MazeView &mv, int sym) {
+    if (sym == 0) return mazeHash(mv);
+    bool transpose = sym & 4;
+    int W = mv.mazeW, H = mv.mazeH;
+    int tw = transpose ? H : W, th = transpose ? W : H;
+    size_t stride = (size_t)(tw + 63) / 64 + 2;
+    std::vector<uint64_t> right((size_t)(th + 2) * stride, 0), down(right.size(), 0);
+    auto image = [&](int x, int y) {
+        Point p = transpose ? Point{ y, x } : Point{ x, y };
+        if (sym & 1) p.x = tw - 1 - p.x;
+        if (sym & 2) p.y = th - 1 - p.y;
+        return p;
+    };
+    auto open = [&](Point a, Point b) {
+        bool across = a.y == b.y;
+        int x = std::min(a.x, b.x), y = std::min(a.y, b.y);
+        (across ? right : down)[(size_t)(y + 1) * stride + 1 + x / 64] |= 1ULL << (x % 64);
+    };
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            if (mv.canMove(x, y, 1)) open(image(x, y), image(x + 1, y));
+            if (mv.canMove(x, y, 2)) open(image(x, y), image(x, y + 1));
+        }
+    }
+    return mazePlanesHash(tw, th, stride, right.data(), down.data());
+}
+
+inline uint64_t canonicalMazeHash(const MazeView &mv) {
+    uint64_t best = UINT64_MAX;
+    for (int sym = 0; sym < 8; sym++) best = std::min(best, symmetryHash(mv, sym));
+    return best;
+}
+
+inline uint64_t canonicalMazeHash(const Maze &mz) {
+    MazeView mv;
+    mv.fromMaze(mz);
+    return canonicalMazeHash(mv);
+}
+
+/* ---------- Checkpoint files ---------- */
+// A long run keeps its state in a file mapping and commits now and then:
+// msync writes back only the pages dirtied since the last commit, then a
+// small record (progress cursor and one counter) goes into the older of
+// two header slots, so a torn record leaves the other one valid. Pages
+// written after the last commit may reach the file in any order; every
+// resume rebuilds its state from data that was settled at the cursor.
+// MAZE_CHECKPOINT_SECS sets the commit interval (default 60 seconds).
+struct CheckpointRecord { uint64_t seq, cursor, counter, check; };
+struct CheckpointHeader {
+    char magic[8];              // "MAZECKP1"
+    uint32_t kind, width, height, pad;
+    uint64_t param, dataBytes;
+    CheckpointRecord slot[2];
+};
+static const char CHECKPOINT_MAGIC[8] = { 'M','A','Z','E','C','K','P','1' };
+
+class CheckpointFile {
+public:
+    enum Kind : uint32_t { GENERATE = 1, SOLVE_BFS = 2, SOLVE_DIJKSTRA = 3, SOLVE_ASTAR = 4 };
+    static const size_t HEADER_BYTES = 4096;
+
+    CheckpointFile() {}
+    CheckpointFile(const CheckpointFile &) = delete;
+    CheckpointFile &operator=(const CheckpointFile &) = delete;
+    ~CheckpointFile() { release(); }
+
+    // Maps `path` for a job (kind, size, param), keeping its last commit if
+    // the file already holds the same job and starting it empty otherwise.
+    // The data region reads as zeros until written.
+    bool open(const std::string &path, uint32_t kind, int W, int H, uint64_t param,
+              size_t dataBytes, std::string &err) {
+#ifdef _WIN32
+        (void)path; (void)kind; (void)W; (void)H; (void)param; (void)dataBytes;
+        err = "checkpoint files are not supported on this platform";
+        return false;
+#else
+        release();
+        const char *env = getenv("MAZE_CHECKPOINT_SECS");
+        interval = std::chrono::seconds(env ? std::max(1, atoi(env)) : 60);
+        lastCommit = std::chrono::steady_clock::now();
+        fileName = path;
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) { err = "cannot open " + path; return false; }
+        len = HEADER_BYTES + dataBytes;
+        struct stat st;
+        bool reuse = fstat(fd, &st) == 0 && (size_t)st.st_size == len;
+        if (!reuse && (ftruncate(fd, 0) != 0 || ftruncate(fd, (off_t)len) != 0)) {
+            err = "cannot size " + path;
+            release();
+            return false;
+        }
+        void *p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            err = "cannot map " + path;
+            release();
+            return false;
+        }
+        base = (char *)p;
+        CheckpointHeader &hdr = header();
+        if (reuse && memcmp(hdr.magic, CHECKPOINT_MAGIC, sizeof hdr.magic) == 0 &&
+            hdr.kind == kind && hdr.width == (uint32_t)W && hdr.height == (uint32_t)H &&
+            hdr.param == param && hdr.dataBytes == dataBytes) {
+            for (const CheckpointRecord &r : hdr.slot) {
+                if (r.seq > 0 && r.check == checkOf(r) && (!last || r.seq > last->seq)) last = &r;
+            }
+            if (last) return true;
+        }
+        if (reuse) {
+            // Another job, or this one before its first commit: start over
+            // on a zeroed file.
+            munmap(base, len);
+            base = nullptr;
+            if (ftruncate(fd, 0) != 0 || ftruncate(fd, (off_t)len) != 0 ||
+                (p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+                err = "cannot reset " + path;
+                release();
+                return false;
+            }
+            base = (char *)p;
+        }
+        CheckpointHeader &fresh = header();
+        memcpy(fresh.magic, CHECKPOINT_MAGIC, sizeof fresh.magic);
+        fresh.kind = kind;
+        fresh.width = (uint32_t)W;
+        fresh.height = (uint32_t)H;
+        fresh.param = param;
+        fresh.dataBytes = dataBytes;
+        msync(base, HEADER_BYTES, MS_SYNC);
+        return true;
+#endif
+    }
+
+    bool resumed() const { return last != nullptr; }
+    uint64_t cursor() const { return last ? last->cursor : 0; }
+    uint64_t counter() const { return last ? last->counter : 0; }
+    void *data() const { return base + HEADER_BYTES; }
+
+    bool due() const { return std::chrono::steady_clock::now() - lastCommit >= interval; }
+
+    // Makes the data region durable as of `cursor`, then records it.
+    bool commit(uint64_t cursor, uint64_t counter) {
+        lastCommit = std::chrono::steady_clock::now();
+#ifdef _WIN32
+        (void)cursor; (void)counter;
+        return false;
+#else
+        if (msync(base + HEADER_BYTES, len - HEADER_BYTES, MS_SYNC) != 0) return false;
+        CheckpointHeader &hdr = header();
+        CheckpointRecord &r = hdr.slot[last == &hdr.slot[0] ? 1 : 0];
+        r.seq = (last ? last->seq : 0) + 1;
+        r.cursor = cursor;
+        r.counter = counter;
+        r.check = checkOf(r);
+        last = &r;
+        return msync(base, HEADER_BYTES, MS_SYNC) == 0;
+#endif
+    }
+
+    // The job is done: drop the mapping and delete the file.
+    void remove() {
+        release();
+#ifndef _WIN32
+        if (!fileName.empty()) unlink(fileName.c_str());
+#endif
+        fileName.clear();
+    }
+
+private:
+    std::string fileName;
+    int fd = -1;
+    char *base = nullptr;
+    size_t len = 0;
+    const CheckpointRecord *last = nullptr;
+    std::chrono::steady_clock::duration interval{};
+    std::chrono::steady_clock::time_point lastCommit;
+
+    CheckpointHeader &header() const { return *(CheckpointHeader *)base; }
+
+    uint64_t checkOf(const CheckpointRecord &r) const {
+        const CheckpointHeader &hdr = header();
+        MazeHasher hs((int)hdr.width, (int)hdr.height);
+        for (uint64_t v : { (uint64_t)hdr.kind, hdr.param, r.seq, r.cursor, r.counter }) hs.update(v);
+        return hs.digest();
+    }
+
+    void release() {
+#ifndef _WIN32
+        if (base) munmap(base, len);
+        if (fd >= 0) ::close(fd);
+#endif
+        base = nullptr;
+        fd = -1;
+        last = nullptr;
+    }
+};
+
+// The union-find state is not stored: the joined-edge bits rebuild it.
+// Bits that reached the file after the last commit are edges the run was
+// going to join anyway, so replaying from the cursor gives the same maze.
+template<typename Index>
+bool Maze::kruskalCheckpointed(unsigned seed, const std::string &checkpoint, std::string &err) {
+    size_t words = ((size_t)mazeW * mazeH * 2 + 63) / 64;
+    CheckpointFile ckp;
+    if (!ckp.open(checkpoint, CheckpointFile::GENERATE, mazeW, mazeH, seed, words * sizeof(uint64_t), err))
+        return false;
+    uint64_t *joined = (uint64_t *)ckp.data();
+    auto forEachJoined = [&](auto fn) {
+        for (size_t w = 0; w < words; w++) {
+            if (!joined[w]) continue;
+            for (int k = 0; k < 64; k++) {
+                if ((joined[w] >> k) & 1) fn((uint64_t)w * 64 + k);
+            }
+        }
+    };
+
+    BasicDisjointSet<Index> ds((Index)mazeW * mazeH);
+    if (ckp.resumed()) {
+        forEachJoined([&](uint64_t e) {
+            Index a = (Index)(e / 2);
+            ds.unite(a, (e & 1) ? (a + mazeW) : (a + 1));
+        });
+    }
+    auto edges = shuffledEdges<Index>(seed);
+    joinEdges(edges, (size_t)ckp.cursor(), ds,
+              [&](uint64_t e) { joined[e / 64] |= 1ULL << (e % 64); },
+              [&](size_t done) { if (ckp.due()) ckp.commit(done, 0); });
+    forEachJoined([&](uint64_t e) { removeWall(e); });
+    ckp.remove();
+    return true;
+}
+
+inline bool Maze::generateRandom(unsigned seed, const std::string &checkpoint, std::string &err) {
+    if (needsWideIndex(mazeW, mazeH)) return kruskalCheckpointed<int64_t>(seed, checkpoint, err);
+    return kruskalCheckpointed<int>(seed, checkpoint, err);
+}
+
+/* ---------- Lazily paged, generation-stamped arrays ---------- */
+// Solver state (distances, parents) for mazes far larger than any one
+// query touches. The storage is one untouched LargePageAllocator block,
+// so the OS only backs the pages that get written (with huge pages under
+// MAZE_HUGEPAGES). Pages of 4096 entries carry the generation that last
+// filled them; reset() starts a new generation in O(1), and a stale page
+// is refilled only when written again. Setup is O(cells touched) instead
+// of O(N), apart from the stamp table (one word per page).
+template<typename T>
+class PagedArray {
+public:
+    static const int PAGE_BITS = 12;
+    static const size_t PAGE = size_t(1) << PAGE_BITS;
+
+    PagedArray(size_t n, T fillValue)
+        : fillValue(fillValue), stamps((n + PAGE - 1) >> PAGE_BITS, 0) {
+        slab.resize(stamps.size() << PAGE_BITS);
+    }
+
+    void reset() {
+        if (++gen == 0) { std::fill(stamps.begin(), stamps.end(), 0); gen = 1; }
+        touched = 0;
+    }
+    // Pages filled in the current generation.
+    size_t pagesTouched() const { return touched; }
+
+    // Reading never allocates; untouched entries hold fillValue.
+    T operator[](size_t i) const {
+        size_t p = i >> PAGE_BITS;
+        return stamps[p] == gen ? slab[i] : fillValue;
+    }
+    T &operator[](size_t i) {
+        size_t p = i >> PAGE_BITS;
+        if (stamps[p] != gen) refill(p);
+        return slab[i];
+    }
+
+private:
+    T fillValue;
+    std::vector<T, LargePageAllocator<T>> slab;
+    std::vector<uint32_t> stamps;
+    uint32_t gen = 1;
+    size_t touched = 0;
+
+    void refill(size_t p) {
+        std::fill_n(slab.data() + (p << PAGE_BITS), PAGE, fillValue);
+        stamps[p] = gen;
+        touched++;
+    }
+};
+
+/* ---------- Shortest path with reusable scratch ---------- */
+// BFS over a Maze or a MazeView. Distances and parents live in paged
+// arrays, so a short query on a huge maze only pays for what it visits.
+// One scratch per thread.
+template<typename Index>
+struct BasicPathScratch {
+    PagedArray<Index> parent, dist;
+    std::vector<Index, LargePageAllocator<Index>> que;
+    size_t expanded = 0;        // cells dequeued by the last search
+
+    explicit BasicPathScratch(Index N) : parent((size_t)N, -1), dist((size_t)N, -1) {}
+
+    // Distance from `from` to `to`, or -1; parents are valid until the next call.
+    template<typename Graph>
+    Index search(const Graph &mz, Index from, Index to) {
+        parent.reset();
+        dist.reset();
+        que.clear();
+        Index W = mz.mazeW;
+        dist[from] = 0;
+        que.push_back(from);
+        for (size_t head = 0; head < que.size(); head++) {
+            Index u = que[head];
+            expanded = head + 1;
+            if (u == to) return dist[u];
+            Point pu = cellPoint(u, mz.mazeW);
+            Index du = dist[u];
+            for (int dir = 0; dir < 4; dir++) {
+                if (!mz.canMove(pu.x, pu.y, dir)) continue;
+                Index v = dir == 0 ? u - W : dir == 1 ? u + 1 : dir == 2 ? u + W : u - 1;
+                Index &dv = dist[v];
+                if (dv >= 0) continue;
+                dv = du + 1;
+                parent[v] = u;
+                que.push_back(v);
+            }
+        }
+        return -1;
+    }
+};
+using PathScratch = BasicPathScratch<int>;
+
+#endif // MAZE_CORE_H